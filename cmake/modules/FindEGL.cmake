@@ -0,0 +1,28 @@
+
+# - Try to find EGL
+#
+# The following are set after configuration is done:
+#  EGL_FOUND
+#  EGL_INCLUDE_DIRS
+#  EGL_LIBRARIES
+#
+# And the imported target EGL::EGL
+
+include(FindPackageHandleStandardArgs)
+
+find_path(EGL_INCLUDE_DIR EGL/egl.h)
+find_library(EGL_LIBRARY EGL)
+
+find_package_handle_standard_args(EGL DEFAULT_MSG
+    EGL_INCLUDE_DIR EGL_LIBRARY)
+
+if(EGL_FOUND)
+    set(EGL_INCLUDE_DIRS ${EGL_INCLUDE_DIR})
+    set(EGL_LIBRARIES ${EGL_LIBRARY})
+
+    add_library(EGL::EGL UNKNOWN IMPORTED)
+    set_target_properties(EGL::EGL PROPERTIES
+        INTERFACE_INCLUDE_DIRECTORIES ${EGL_INCLUDE_DIR}
+        IMPORTED_LOCATION ${EGL_LIBRARY}
+        )
+endif()
@@ -0,0 +1,246 @@
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <boost/make_shared.hpp>
+#include <glog/logging.h>
+#include "../fmri/FlatLayerVisualisation.hpp"
+#include "../fmri/Texture.hpp"
+#include "../fmri/utils.hpp"
+#include "../fmri/visualisations.hpp"
+
+using namespace fmri;
+
+// Shapes follow VGG-16, the largest network commonly visualised.
+static const std::vector<int> CONV_SHAPE = {1, 64, 224, 224};
+static const std::vector<int> POOLED_SHAPE = {1, 64, 112, 112};
+static const std::vector<int> FC_SHAPE = {1, 4096};
+
+static std::vector<float> randomData(std::size_t n, float mean = 0, float stddev = 1)
+{
+    std::mt19937 generator(42);
+    std::normal_distribution<float> distribution(mean, stddev);
+
+    std::vector<float> data(n);
+    std::generate(data.begin(), data.end(), [&]() { return distribution(generator); });
+
+    return data;
+}
+
+static std::size_t numEntries(const std::vector<int> &shape)
+{
+    std::size_t entries = 1;
+    for (auto dim : shape) {
+        entries *= dim;
+    }
+
+    return entries;
+}
+
+/**
+ * Two consecutive layer states with everything needed to build the interaction between them.
+ */
+struct LayerPair
+{
+    LayerData prev;
+    LayerData cur;
+    LayerInfo info;
+    std::vector<float> prevPositions;
+    std::vector<float> curPositions;
+
+    /**
+     * @param type Caffe type name of the layer producing cur.
+     * @param shape Shape of both layer states.
+     * @param transform Computes the current state from the previous one.
+     * @param parameters Parameter blobs of the layer.
+     */
+    template<class Transform>
+    LayerPair(std::string_view type, const std::vector<int> &shape, Transform transform,
+              const std::vector<boost::shared_ptr<caffe::Blob<DType>>> &parameters = {}) :
+            LayerPair(type, shape, shape, randomData(numEntries(shape)), transform, parameters)
+    {
+    }
+
+    template<class Transform>
+    LayerPair(std::string_view type, const std::vector<int> &prevShape, const std::vector<int> &curShape,
+              std::vector<float> prevData, Transform transform,
+              const std::vector<boost::shared_ptr<caffe::Blob<DType>>> &parameters) :
+            prev("prev", prevShape, prevData.data()),
+            cur("cur", curShape, transform(prevData).data()),
+            info("cur", type, parameters)
+    {
+        std::unique_ptr<LayerVisualisation> prevVisualisation(getVisualisationForLayer(prev, LayerInfo("prev", "Convolution", {})));
+        std::unique_ptr<LayerVisualisation> curVisualisation(getVisualisationForLayer(cur, info));
+        prevPositions = prevVisualisation->nodePositions();
+        curPositions = curVisualisation->nodePositions();
+    }
+};
+
+static void buildAnimation(benchmark::State &state, const LayerPair &layers)
+{
+    for (auto _ : state) {
+        std::unique_ptr<Animation> animation(getActivityAnimation(layers.prev, layers.cur, layers.info,
+                                                                  layers.prevPositions, layers.curPositions));
+        benchmark::DoNotOptimize(animation.get());
+    }
+    state.SetItemsProcessed(state.iterations() * layers.cur.numEntries());
+}
+
+static void BM_rescale(benchmark::State &state)
+{
+    auto data = randomData(state.range(0));
+    for (auto _ : state) {
+        rescale(data.begin(), data.end(), 0.f, 1.f);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_rescale)->Arg(224 * 224)->Arg(numEntries(CONV_SHAPE));
+
+static void BM_arg_partial_sort(benchmark::State &state)
+{
+    const auto data = randomData(4096 * 4096);
+    const auto limit = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+        auto indices = arg_partial_sort(data.begin(), data.begin() + limit, data.end(), [](auto a, auto b) {
+            return std::abs(a) > std::abs(b);
+        });
+        benchmark::DoNotOptimize(indices.data());
+    }
+    state.SetItemsProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_arg_partial_sort)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+static void BM_numCols(benchmark::State &state)
+{
+    const auto limit = state.range(0);
+    for (auto _ : state) {
+        for (auto i = 1; i <= limit; ++i) {
+            benchmark::DoNotOptimize(numCols(i));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * limit);
+}
+BENCHMARK(BM_numCols)->Arg(4096);
+
+static void BM_animate(benchmark::State &state)
+{
+    // Three coordinates per vertex.
+    const auto start = randomData(3 * state.range(0));
+    const auto delta = randomData(3 * state.range(0));
+    float time = 0;
+    for (auto _ : state) {
+        const auto &result = animate(start, delta, time);
+        benchmark::DoNotOptimize(result.data());
+        time = std::fmod(time + 0.01f, 1.f);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_animate)->Arg(10000)->Arg(512 * 4);
+
+static void BM_intensityFunction(benchmark::State &state)
+{
+    const auto data = randomData(state.range(0));
+    const auto limit = *std::max_element(data.begin(), data.end());
+    for (auto _ : state) {
+        for (auto value : data) {
+            benchmark::DoNotOptimize(FlatLayerVisualisation::intensityFunction(value, limit));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_intensityFunction)->Arg(10000);
+
+static void BM_Texture_preCalc(benchmark::State &state)
+{
+    // Texture construction is dominated by preCalc, and needs no GL context.
+    const auto &shape = CONV_SHAPE;
+    const auto data = randomData(numEntries(shape));
+    for (auto _ : state) {
+        Texture texture(data.data(), shape[3], shape[2] * shape[1], GL_LUMINANCE, shape[1]);
+        benchmark::DoNotOptimize(&texture);
+    }
+    state.SetItemsProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_Texture_preCalc)->Unit(benchmark::kMillisecond);
+
+static void BM_deduplicate(benchmark::State &state)
+{
+    // Dropout after a 512x14x14 layer maps every activation to one of 512 nodes.
+    const auto entries = static_cast<std::size_t>(state.range(0));
+    const auto strengths = randomData(entries);
+    EntryList list;
+    list.reserve(entries);
+    for (auto i = 0u; i < entries; ++i) {
+        list.emplace_back(strengths[i], std::make_pair(i / 196, i / 196));
+    }
+
+    for (auto _ : state) {
+        auto result = deduplicate(list);
+        benchmark::DoNotOptimize(result.data());
+    }
+    state.SetItemsProcessed(state.iterations() * entries);
+}
+BENCHMARK(BM_deduplicate)->Arg(512 * 14 * 14)->Unit(benchmark::kMillisecond);
+
+static void BM_FullyConnectedAnimation(benchmark::State &state)
+{
+    // fc7: 4096 inputs to 4096 outputs.
+    auto weights = boost::make_shared<caffe::Blob<DType>>(std::vector<int>{4096, 4096});
+    const auto values = randomData(4096 * 4096, 0, 0.01);
+    std::copy(values.begin(), values.end(), weights->mutable_cpu_data());
+
+    LayerPair layers("InnerProduct", FC_SHAPE, FC_SHAPE, randomData(4096), [](auto data) { return data; }, {weights});
+    buildAnimation(state, layers);
+}
+BENCHMARK(BM_FullyConnectedAnimation)->Unit(benchmark::kMillisecond);
+
+static void BM_ReLUAnimation(benchmark::State &state, const std::vector<int> &shape)
+{
+    LayerPair layers("ReLU", shape, [](auto data) {
+        std::transform(data.begin(), data.end(), data.begin(), [](float f) { return std::max(f, 0.f); });
+        return data;
+    });
+    buildAnimation(state, layers);
+}
+BENCHMARK_CAPTURE(BM_ReLUAnimation, flat, FC_SHAPE)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ReLUAnimation, image, CONV_SHAPE)->Unit(benchmark::kMillisecond);
+
+static void BM_LRNAnimation(benchmark::State &state, const std::vector<int> &shape)
+{
+    LayerPair layers("LRN", shape, [](auto data) {
+        std::transform(data.begin(), data.end(), data.begin(), [](float f) { return f / (1 + 0.1f * f * f); });
+        return data;
+    });
+    buildAnimation(state, layers);
+}
+BENCHMARK_CAPTURE(BM_LRNAnimation, flat, FC_SHAPE)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_LRNAnimation, image, POOLED_SHAPE)->Unit(benchmark::kMillisecond);
+
+static void BM_DropoutAnimation(benchmark::State &state)
+{
+    LayerPair layers("Dropout", FC_SHAPE, [](auto data) {
+        for (auto i = 0u; i < data.size(); i += 2) {
+            data[i] = 0;
+        }
+        return data;
+    });
+    buildAnimation(state, layers);
+}
+BENCHMARK(BM_DropoutAnimation)->Unit(benchmark::kMillisecond);
+
+int main(int argc, char **argv)
+{
+    // Building visualisations logs every layer, which drowns out the results.
+    FLAGS_minloglevel = google::GLOG_WARNING;
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+
+    return 0;
+}
@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <glog/logging.h>
+#include "ActivationIndex.hpp"
+#include "BinaryFile.hpp"
+
+using namespace fmri;
+
+static constexpr char MAGIC[8] = {'F', 'M', 'R', 'I', 'T', 'O', 'P', 'K'};
+static constexpr std::uint32_t VERSION = 1;
+// Input of unused entries, for units with fewer than k inputs.
+static constexpr std::uint32_t NO_INPUT = std::numeric_limits<std::uint32_t>::max();
+
+// The file starts with the header, followed by the layer and input
+// tables. Then come k entries per unit for every layer, and finally the
+// names and paths the tables point to. Offsets are from the file start.
+struct IndexHeader
+{
+    FileHeader file;
+    std::uint32_t k;
+    std::uint32_t inputs;
+    std::uint32_t layers;
+    std::uint32_t reserved;
+};
+
+struct IndexLayer
+{
+    std::uint64_t name;
+    std::uint32_t nameLength;
+    std::uint32_t units;
+    std::uint64_t entries;
+};
+
+struct IndexInput
+{
+    std::uint64_t path;
+    std::uint32_t pathLength;
+    std::uint32_t reserved;
+};
+
+struct IndexEntry
+{
+    float score;
+    std::uint32_t input;
+};
+
+ActivationIndex::Builder::Builder(std::size_t k) :
+        k(k)
+{
+    CHECK_GT(k, 0) << "At least one input per unit should be kept.";
+}
+
+void ActivationIndex::Builder::add(std::uint32_t input, const std::vector<LayerData> &layers)
+{
+    if (this->layers.empty()) {
+        for (auto &layer : layers) {
+            const auto &shape = layer.shape();
+            const auto units = shape.size() == 4 ? shape[1] : layer.numEntries();
+            this->layers.push_back({layer.name(), layer.numEntries() / units, decltype(Layer::heaps)(units)});
+        }
+    }
+    CHECK_EQ(layers.size(), this->layers.size()) << "Inputs should have the same layers.";
+
+    for (auto i = 0u; i < layers.size(); ++i) {
+        add(i, input, layers[i]);
+    }
+}
+
+void ActivationIndex::Builder::add(std::size_t layer, std::uint32_t input, const LayerData &data)
+{
+    auto &index = layers.at(layer);
+    CHECK_EQ(data.name(), index.name) << "Inputs should have the same layers.";
+    CHECK_EQ(data.numEntries(), index.heaps.size() * index.unitSize) << "Inputs should have the same shape for " << index.name;
+
+    for (auto unit = 0u; unit < index.heaps.size(); ++unit) {
+        const auto values = data.data() + unit * index.unitSize;
+        const auto score = *std::max_element(values, values + index.unitSize);
+        auto &heap = index.heaps[unit];
+
+        // Min-heap on the score, so the weakest kept input is at the front.
+        if (heap.size() < k) {
+            heap.emplace_back(score, input);
+            std::push_heap(heap.begin(), heap.end(), std::greater<>());
+        } else if (score > heap.front().first) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<>());
+            heap.back() = {score, input};
+            std::push_heap(heap.begin(), heap.end(), std::greater<>());
+        }
+    }
+}
+
+void ActivationIndex::Builder::save(const std::string &path, const std::vector<std::string> &relativeInputs) const
+{
+    // The index is opened from other working directories, so relative paths would not resolve.
+    std::vector<std::string> inputs;
+    for (auto &input : relativeInputs) {
+        inputs.push_back(std::filesystem::absolute(input).lexically_normal().string());
+    }
+
+    std::ofstream out(path, std::ios::binary);
+    CHECK(out) << "Failed to open " << path;
+
+    IndexHeader header = {};
+    header.file = FileHeader(MAGIC, VERSION);
+    header.k = k;
+    header.inputs = inputs.size();
+    header.layers = layers.size();
+    writeValue(out, header);
+
+    std::uint64_t entries = sizeof(IndexHeader) + layers.size() * sizeof(IndexLayer) + inputs.size() * sizeof(IndexInput);
+    std::uint64_t strings = entries;
+    for (auto &layer : layers) {
+        strings += layer.heaps.size() * k * sizeof(IndexEntry);
+    }
+
+    for (auto &layer : layers) {
+        writeValue(out, IndexLayer{strings, static_cast<std::uint32_t>(layer.name.size()),
+                                   static_cast<std::uint32_t>(layer.heaps.size()), entries});
+        strings += layer.name.size();
+        entries += layer.heaps.size() * k * sizeof(IndexEntry);
+    }
+    for (auto &input : inputs) {
+        writeValue(out, IndexInput{strings, static_cast<std::uint32_t>(input.size()), 0});
+        strings += input.size();
+    }
+
+    for (auto &layer : layers) {
+        for (auto heap : layer.heaps) {
+            std::sort_heap(heap.begin(), heap.end(), std::greater<>());
+            for (auto i = 0u; i < k; ++i) {
+                writeValue(out, i < heap.size() ? IndexEntry{heap[i].first, heap[i].second} : IndexEntry{0, NO_INPUT});
+            }
+        }
+    }
+
+    for (auto &layer : layers) {
+        out << layer.name;
+    }
+    for (auto &input : inputs) {
+        out << input;
+    }
+
+    CHECK(out) << "Failed to write " << path;
+}
+
+ActivationIndex::ActivationIndex(const std::string &path)
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+    PCHECK(fd >= 0) << "Failed to open " << path;
+
+    struct stat s;
+    PCHECK(fstat(fd, &s) == 0) << "Failed to read " << path;
+    size = s.st_size;
+    CHECK_GE(size, sizeof(IndexHeader)) << path << " is not an activation index.";
+
+    auto mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    PCHECK(mapping != MAP_FAILED) << "Failed to map " << path;
+    data = static_cast<const char *>(mapping);
+
+    at<IndexHeader>(0)->file.check(MAGIC, VERSION, path, "an activation index");
+}
+
+ActivationIndex::~ActivationIndex()
+{
+    munmap(const_cast<char *>(data), size);
+}
+
+template<class T>
+const T *ActivationIndex::at(std::uint64_t offset, std::size_t count) const
+{
+    CHECK_LE(offset + count * sizeof(T), size) << "Activation index is truncated.";
+    return reinterpret_cast<const T *>(data + offset);
+}
+
+std::string_view ActivationIndex::string(std::uint64_t offset, std::uint32_t length) const
+{
+    return {at<char>(offset, length), length};
+}
+
+std::vector<ActivationIndex::Match> ActivationIndex::lookup(std::string_view layer, std::size_t unit) const
+{
+    const auto header = at<IndexHeader>(0);
+    const auto layers = at<IndexLayer>(sizeof(IndexHeader), header->layers);
+    const auto inputs = at<IndexInput>(sizeof(IndexHeader) + header->layers * sizeof(IndexLayer), header->inputs);
+
+    const auto match = std::find_if(layers, layers + header->layers, [this, layer](const IndexLayer &entry) {
+        return string(entry.name, entry.nameLength) == layer;
+    });
+    if (match == layers + header->layers || unit >= match->units) {
+        return {};
+    }
+
+    const auto entries = at<IndexEntry>(match->entries + unit * header->k * sizeof(IndexEntry), header->k);
+    std::vector<Match> result;
+    for (auto i = 0u; i < header->k && entries[i].input != NO_INPUT; ++i) {
+        CHECK_LT(entries[i].input, header->inputs) << "Activation index is corrupt.";
+        const auto &input = inputs[entries[i].input];
+        result.push_back({entries[i].score, string(input.path, input.pathLength)});
+    }
+
+    return result;
+}
+
+std::size_t ActivationIndex::k() const
+{
+    return at<IndexHeader>(0)->k;
+}
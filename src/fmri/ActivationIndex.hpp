@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "LayerData.hpp"
+
+namespace fmri
+{
+    /**
+     * Index of the inputs that activate every unit the most.
+     *
+     * Units are channels for convolutional layers, scored by their
+     * strongest activation, and single neurons for other layers. The
+     * index file is memory mapped, so opening it is cheap regardless of
+     * its size and a lookup only touches the entries of a single unit.
+     */
+    class ActivationIndex
+    {
+    public:
+        /**
+         * An input that strongly activates a unit.
+         */
+        struct Match
+        {
+            float score;
+            std::string_view input;
+        };
+
+        /**
+         * Collects the top inputs of every unit over a dataset.
+         *
+         * Only a bounded heap per unit is kept, so memory use does not
+         * depend on the number of inputs.
+         */
+        class Builder
+        {
+        public:
+            /**
+             * @param k Number of inputs to keep per unit.
+             */
+            explicit Builder(std::size_t k);
+
+            /**
+             * Add the activations of a single input.
+             *
+             * @param input Index of the input.
+             * @param layers Activations of every layer. The layers must match those added before.
+             */
+            void add(std::uint32_t input, const std::vector<LayerData>& layers);
+            /**
+             * Add the activations of a single layer for a single input.
+             *
+             * Different layers can be added from different threads, as long
+             * as all layers were added at least once before.
+             */
+            void add(std::size_t layer, std::uint32_t input, const LayerData& data);
+
+            /**
+             * @param path File to write the index to.
+             * @param inputs Paths of all inputs, by index. Stored as absolute paths.
+             */
+            void save(const std::string& path, const std::vector<std::string>& inputs) const;
+
+        private:
+            struct Layer
+            {
+                std::string name;
+                // Number of values scored together, 1 unless the layer has channels.
+                std::size_t unitSize;
+                std::vector<std::vector<std::pair<float, std::uint32_t>>> heaps;
+            };
+
+            std::size_t k;
+            std::vector<Layer> layers;
+        };
+
+        explicit ActivationIndex(const std::string& path);
+        ActivationIndex(const ActivationIndex&) = delete;
+        ActivationIndex& operator=(const ActivationIndex&) = delete;
+        ~ActivationIndex();
+
+        /**
+         * Find the inputs that activate a unit the most.
+         *
+         * @param layer Name of the layer.
+         * @param unit Channel or neuron index within the layer.
+         * @return Up to k() inputs, strongest first. Empty if the unit is not indexed.
+         */
+        std::vector<Match> lookup(std::string_view layer, std::size_t unit) const;
+
+        std::size_t k() const;
+
+    private:
+        const char* data;
+        std::size_t size;
+
+        template<class T>
+        const T* at(std::uint64_t offset, std::size_t count = 1) const;
+        std::string_view string(std::uint64_t offset, std::uint32_t length) const;
+    };
+}
@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <glog/logging.h>
+#include "ActivationStatistics.hpp"
+#include "BinaryFile.hpp"
+
+using namespace fmri;
+
+static constexpr char MAGIC[8] = {'F', 'M', 'R', 'I', 'S', 'T', 'A', 'T'};
+static constexpr std::uint32_t VERSION = 1;
+
+ActivationStatistics::Layer ActivationStatistics::emptyLayer(const LayerData &data)
+{
+    const auto size = data.numEntries();
+
+    Layer layer;
+    layer.name = data.name();
+    layer.shape = data.shape();
+    layer.mean.resize(size);
+    layer.m2.resize(size);
+    layer.max.resize(size, -std::numeric_limits<float>::infinity());
+    layer.active.resize(size);
+
+    return layer;
+}
+
+void ActivationStatistics::add(const std::vector<LayerData> &layers)
+{
+    if (layers_.empty()) {
+        std::transform(layers.begin(), layers.end(), std::back_inserter(layers_), emptyLayer);
+    }
+    CHECK_EQ(layers.size(), layers_.size()) << "Inputs should have the same layers.";
+
+    for (auto i = 0u; i < layers.size(); ++i) {
+        add(i, layers[i]);
+    }
+}
+
+void ActivationStatistics::add(std::size_t layer, const LayerData &data)
+{
+    auto &stats = layers_.at(layer);
+    CHECK_EQ(data.name(), stats.name) << "Inputs should have the same layers.";
+    CHECK_EQ(data.numEntries(), stats.mean.size()) << "Inputs should have the same shape for " << stats.name;
+
+    const auto count = ++stats.count;
+    const auto size = data.numEntries();
+    const auto values = data.data();
+    for (auto i = 0u; i < size; ++i) {
+        const double value = values[i];
+        const auto delta = value - stats.mean[i];
+        stats.mean[i] += delta / count;
+        stats.m2[i] += delta * (value - stats.mean[i]);
+        stats.max[i] = std::max(stats.max[i], values[i]);
+        stats.active[i] += std::abs(values[i]) > EPSILON;
+    }
+}
+
+void ActivationStatistics::merge(const ActivationStatistics &other)
+{
+    if (layers_.empty()) {
+        layers_ = other.layers_;
+        return;
+    }
+    CHECK_EQ(layers_.size(), other.layers_.size()) << "Statistics should be for the same network.";
+
+    for (auto i = 0u; i < layers_.size(); ++i) {
+        auto &stats = layers_[i];
+        const auto &add = other.layers_[i];
+        CHECK_EQ(stats.name, add.name) << "Statistics should be for the same network.";
+        CHECK(stats.shape == add.shape) << "Statistics should have the same shape for " << stats.name;
+
+        const auto count = stats.count + add.count;
+        if (add.count == 0) {
+            continue;
+        }
+
+        // Chan et al.'s method for combining the variances of two sets.
+        const double weight = static_cast<double>(add.count) / count;
+        const double crossWeight = static_cast<double>(stats.count) * weight;
+        for (auto j = 0u; j < stats.mean.size(); ++j) {
+            const auto delta = add.mean[j] - stats.mean[j];
+            stats.mean[j] += delta * weight;
+            stats.m2[j] += add.m2[j] + delta * delta * crossWeight;
+            stats.max[j] = std::max(stats.max[j], add.max[j]);
+            stats.active[j] += add.active[j];
+        }
+
+        stats.count = count;
+    }
+}
+
+std::uint64_t ActivationStatistics::count() const
+{
+    return layers_.empty() ? 0 : layers_.front().count;
+}
+
+std::vector<LayerData> ActivationStatistics::layers(Statistic statistic) const
+{
+    std::vector<LayerData> result;
+    result.reserve(layers_.size());
+
+    std::vector<DType> values;
+    for (auto &stats : layers_) {
+        const auto size = stats.mean.size();
+        const double count = std::max<std::uint64_t>(stats.count, 1);
+        values.resize(size);
+
+        for (auto i = 0u; i < size; ++i) {
+            switch (statistic) {
+                case Statistic::MEAN:
+                    values[i] = stats.mean[i];
+                    break;
+
+                case Statistic::VARIANCE:
+                    values[i] = stats.m2[i] / count;
+                    break;
+
+                case Statistic::MAX:
+                    values[i] = stats.count ? stats.max[i] : 0;
+                    break;
+
+                case Statistic::SPARSITY:
+                    values[i] = 1 - stats.active[i] / count;
+                    break;
+            }
+        }
+
+        result.emplace_back(stats.name, stats.shape, values.data());
+    }
+
+    return result;
+}
+
+void ActivationStatistics::save(const std::string &path) const
+{
+    std::ofstream out(path, std::ios::binary);
+    CHECK(out) << "Failed to open " << path;
+
+    writeValue(out, FileHeader(MAGIC, VERSION));
+    writeValue<std::uint64_t>(out, layers_.size());
+
+    for (auto &stats : layers_) {
+        writeValue<std::uint32_t>(out, stats.name.size());
+        out.write(stats.name.data(), stats.name.size());
+        writeValue<std::uint32_t>(out, stats.shape.size());
+        writeArray(out, stats.shape);
+        writeValue(out, stats.count);
+        writeArray(out, stats.mean);
+        writeArray(out, stats.m2);
+        writeArray(out, stats.max);
+        writeArray(out, stats.active);
+    }
+
+    CHECK(out) << "Failed to write " << path;
+}
+
+ActivationStatistics ActivationStatistics::load(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    CHECK(in) << "Failed to open " << path;
+
+    const auto header = readValue<FileHeader>(in);
+    CHECK(in) << path << " is not an activation statistics file.";
+    header.check(MAGIC, VERSION, path, "an activation statistics file");
+
+    ActivationStatistics result;
+    result.layers_.resize(readValue<std::uint64_t>(in));
+    for (auto &stats : result.layers_) {
+        stats.name.resize(readValue<std::uint32_t>(in));
+        in.read(stats.name.data(), stats.name.size());
+        readArray(in, stats.shape, readValue<std::uint32_t>(in));
+        stats.count = readValue<std::uint64_t>(in);
+
+        std::size_t size = 1;
+        for (auto dim : stats.shape) {
+            size *= dim;
+        }
+        readArray(in, stats.mean, size);
+        readArray(in, stats.m2, size);
+        readArray(in, stats.max, size);
+        readArray(in, stats.active, size);
+        CHECK(in) << "Unexpected end of " << path;
+    }
+
+    return result;
+}
+
+ActivationStatistics::Statistic ActivationStatistics::parseStatistic(std::string_view name)
+{
+    if (name == "mean") {
+        return Statistic::MEAN;
+    } else if (name == "variance") {
+        return Statistic::VARIANCE;
+    } else if (name == "max") {
+        return Statistic::MAX;
+    } else if (name == "sparsity") {
+        return Statistic::SPARSITY;
+    } else {
+        throw std::invalid_argument("Unknown statistic: " + std::string(name));
+    }
+}
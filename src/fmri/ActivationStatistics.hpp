@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "LayerData.hpp"
+
+namespace fmri
+{
+    /**
+     * Per-neuron activation statistics over a set of inputs.
+     *
+     * Statistics are updated one input at a time with Welford's
+     * algorithm, so memory use does not depend on the number of inputs.
+     * Partial results for disjoint sets of inputs can be saved, and
+     * merged afterwards.
+     */
+    class ActivationStatistics
+    {
+    public:
+        enum class Statistic
+        {
+            MEAN,
+            VARIANCE,
+            MAX,
+            SPARSITY
+        };
+
+        /**
+         * Add the activations of a single input.
+         *
+         * @param layers Activations of every layer. The layers must match those added before.
+         */
+        void add(const std::vector<LayerData>& layers);
+        /**
+         * Add the activations of a single layer for a single input.
+         *
+         * Different layers can be added from different threads, as long
+         * as all layers were added at least once before.
+         *
+         * @param layer Index of the layer.
+         * @param data Activations of that layer.
+         */
+        void add(std::size_t layer, const LayerData& data);
+
+        /**
+         * Combine with the statistics of a disjoint set of inputs.
+         */
+        void merge(const ActivationStatistics& other);
+
+        /**
+         * @return Number of inputs added to the first layer.
+         */
+        std::uint64_t count() const;
+
+        /**
+         * Get a single statistic for every neuron, shaped as the original layers.
+         *
+         * Variance is the population variance. Sparsity is the fraction of
+         * inputs for which a neuron was not activated.
+         */
+        std::vector<LayerData> layers(Statistic statistic) const;
+
+        void save(const std::string& path) const;
+        static ActivationStatistics load(const std::string& path);
+
+        static Statistic parseStatistic(std::string_view name);
+
+    private:
+        struct Layer
+        {
+            std::string name;
+            std::vector<int> shape;
+            std::uint64_t count = 0;
+            std::vector<double> mean;
+            // Sum of squared differences from the mean.
+            std::vector<double> m2;
+            std::vector<float> max;
+            std::vector<std::uint32_t> active;
+        };
+
+        std::vector<Layer> layers_;
+
+        static Layer emptyLayer(const LayerData& data);
+    };
+}
@@ -1,12 +1,15 @@
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <random>
 #include <GL/gl.h>
-#include <caffe/util/math_functions.hpp>
 #include "Range.hpp"
 #include "ActivityAnimation.hpp"
+#include "Colormap.hpp"
+#include "DrawList.hpp"
 #include "RenderingState.hpp"
 #include "glutils.hpp"
+#include "FrameProfiler.hpp"
 
 using namespace std;
 using namespace fmri;
@@ -14,60 +17,121 @@ using namespace fmri;
 ActivityAnimation::ActivityAnimation(
             const std::vector<std::pair<DType, std::pair<std::size_t, std::size_t>>> &interactions,
             const float *aPositions, const float *bPositions) :
-        bufferLength(3 * interactions.size()),
-        delta(bufferLength)
+        bufferLength(3 * interactions.size())
 {
-    startingPos.reserve(bufferLength);
-    vector<float> endPos;
-    endPos.reserve(bufferLength);
-    transform(interactions.begin(), interactions.end(), back_inserter(colorBuffer), [](auto e) {
-        if (e.first > 0) {
-            return interpolate(e.first, POSITIVE_COLOR, NEUTRAL_COLOR);
-        } else {
-            return interpolate(-e.first, NEGATIVE_COLOR, NEUTRAL_COLOR);
-        }
-    });
-    colorBuffer.reserve(interactions.size());
-
+    vector<float> endpoints;
+    endpoints.reserve(2 * bufferLength);
+    valueBuffer.reserve(interactions.size());
+    transform(interactions.begin(), interactions.end(), back_inserter(valueBuffer), [](auto e) { return e.first; });
+    links.reserve(interactions.size());
+    transform(interactions.begin(), interactions.end(), back_inserter(links), [](auto e) { return e.second; });
 
     for (auto &entry : interactions) {
         auto *aPos = &aPositions[3 * entry.second.first];
-        auto *bPos = &bPositions[3 * entry.second.second];
+        endpoints.insert(endpoints.end(), aPos, aPos + 3);
+    }
 
+    for (auto &entry : interactions) {
+        auto *bPos = &bPositions[3 * entry.second.second];
         for (auto i : Range(3)) {
-            startingPos.emplace_back(aPos[i]);
-            endPos.emplace_back(bPos[i] + (i % 3 ? 0 : LAYER_X_OFFSET));
+            endpoints.emplace_back(bPos[i] + (i % 3 ? 0 : LAYER_X_OFFSET));
         }
     }
 
-    caffe::caffe_sub(endPos.size(), endPos.data(), startingPos.data(), delta.data());
-    startingPos.insert(startingPos.end(), endPos.begin(), endPos.end());
+    positions = PackedPositions(endpoints);
+
+    vector<unsigned int> indices;
+    indices.reserve(2 * interactions.size());
     for (auto i : Range(interactions.size())) {
-        lineIndices.push_back(i);
-        lineIndices.push_back(i + interactions.size());
+        indices.push_back(i);
+        indices.push_back(i + interactions.size());
     }
+    lineIndices = IndexBuffer(indices);
+}
+
+/**
+ * Interpolate between packed start and end positions.
+ *
+ * The result is in fixed point steps, so it should be drawn with the
+ * same scaling as the packed positions.
+ */
+static const vector<float> &interpolatePositions(const vector<int16_t> &coordinates, float time)
+{
+    static vector<float> vertexBuffer;
+    const auto length = coordinates.size() / 2;
+    const auto *start = coordinates.data();
+    const auto *end = start + length;
 
-    patchTransparency();
+    vertexBuffer.resize(length);
+    for (auto i = 0u; i < length; ++i) {
+        vertexBuffer[i] = start[i] + time * (end[i] - start[i]);
+    }
+
+    return vertexBuffer;
 }
 
 void ActivityAnimation::draw(float timeScale)
 {
-    const auto &vertexBuffer = animate(startingPos, delta, timeScale);
+    const auto &vertexBuffer = interpolatePositions(positions.coordinates(), timeScale);
+    const auto step = positions.step();
 
+    glPushMatrix();
+    glScalef(step, step, step);
     glEnableClientState(GL_VERTEX_ARRAY);
-    glEnableClientState(GL_COLOR_ARRAY);
-    glColorPointer(std::tuple_size<Color>::value, GL_FLOAT, 0, colorBuffer.data());
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glTexCoordPointer(1, GL_FLOAT, 0, valueBuffer.data());
     glVertexPointer(3, GL_FLOAT, 0, vertexBuffer.data());
+    Colormap::instance().use(Colormap::Scale::LINEAR, getAlpha(), -1, Colormap::Style::POINTS);
     glDrawArrays(GL_POINTS, 0, bufferLength / 3);
-    glDisableClientState(GL_COLOR_ARRAY);
+    FrameProfiler::instance().countDraw(bufferLength / 3);
+    Colormap::instance().release();
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
     glDisableClientState(GL_VERTEX_ARRAY);
+    glPopMatrix();
 }
 
 void ActivityAnimation::drawPaths()
 {
+    glPushMatrix();
     glEnableClientState(GL_VERTEX_ARRAY);
     setGlColor(RenderingState::instance().pathColor());
-    glVertexPointer(3, GL_FLOAT, 0, startingPos.data());
-    glDrawElements(GL_LINES, lineIndices.size(), GL_UNSIGNED_INT, lineIndices.data());
+    positions.bind();
+    lineIndices.draw(GL_LINES);
+    FrameProfiler::instance().countDraw(lineIndices.size());
     glDisableClientState(GL_VERTEX_ARRAY);
+    glPopMatrix();
+}
+
+std::size_t ActivityAnimation::vertexBytes() const
+{
+    return Drawable::vertexBytes() + positions.bytes();
+}
+
+std::size_t ActivityAnimation::indexBytes() const
+{
+    return lineIndices.bytes();
+}
+
+bool ActivityAnimation::compilePaths(DrawList &list) const
+{
+    list.addPaths(positions, lineIndices);
+    return true;
+}
+
+std::vector<std::pair<float, std::size_t>> ActivityAnimation::strongestInputs(std::size_t node, std::size_t limit) const
+{
+    std::vector<std::pair<float, std::size_t>> inputs;
+    for (auto i : Range(links.size())) {
+        if (links[i].second == node) {
+            inputs.emplace_back(valueBuffer[i], links[i].first);
+        }
+    }
+
+    const auto count = min(limit, inputs.size());
+    partial_sort(inputs.begin(), inputs.begin() + count, inputs.end(), [](auto a, auto b) {
+        return abs(a.first) > abs(b.first);
+    });
+    inputs.resize(count);
+
+    return inputs;
 }
@@ -6,6 +6,7 @@
 #include <vector>
 #include "Animation.hpp"
 #include "utils.hpp"
+#include "VertexBuffers.hpp"
 
 namespace fmri
 {
@@ -21,11 +22,17 @@ namespace fmri
 
         void draw(float timeScale) override;
         void drawPaths() override;
+        std::size_t vertexBytes() const override;
+        std::size_t indexBytes() const override;
+        bool compilePaths(DrawList& list) const override;
+        std::vector<std::pair<float, std::size_t>> strongestInputs(std::size_t node, std::size_t limit) const override;
 
     private:
         std::size_t bufferLength;
-        std::vector<float> startingPos;
-        std::vector<float> delta;
-        std::vector<int> lineIndices;
+        // Source and sink node of every interaction.
+        std::vector<std::pair<std::size_t, std::size_t>> links;
+        // Start positions of all interactions, followed by their end positions.
+        PackedPositions positions;
+        IndexBuffer lineIndices;
     };
 }
@@ -10,3 +10,13 @@ void fmri::Animation::drawPaths()
 {
     // Default implementation does nothing.
 }
+
+bool fmri::Animation::compilePaths(DrawList &) const
+{
+    return false;
+}
+
+std::vector<std::pair<float, std::size_t>> fmri::Animation::strongestInputs(std::size_t, std::size_t) const
+{
+    return {};
+}
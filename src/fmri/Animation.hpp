@@ -1,6 +1,9 @@
 #pragma once
 
 
+#include <cstddef>
+#include <utility>
+#include <vector>
 #include "utils.hpp"
 #include "Drawable.hpp"
 
@@ -12,6 +15,24 @@ namespace fmri
         virtual ~Animation() = default;
 
         virtual void drawPaths();
+        /**
+         * Add the interaction paths to the draw list of the input.
+         *
+         * The default implementation adds nothing.
+         *
+         * @return Whether the list replaces drawPaths().
+         */
+        virtual bool compilePaths(DrawList& list) const;
+        /**
+         * Find the strongest interactions that end in a node.
+         *
+         * The default implementation finds none.
+         *
+         * @param node Node of the layer the animation ends in.
+         * @param limit Maximum number of interactions.
+         * @return Strength and source node of every interaction, strongest first.
+         */
+        virtual std::vector<std::pair<float, std::size_t>> strongestInputs(std::size_t node, std::size_t limit) const;
 
     protected:
         float getAlpha() override;
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <glog/logging.h>
+
+namespace fmri
+{
+    /**
+     * Start of the binary files written by fmri-aggregate.
+     *
+     * Files are written in native byte order, the byte order mark detects
+     * files from other machines.
+     */
+    struct FileHeader
+    {
+        static constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byteOrder;
+
+        FileHeader() noexcept = default;
+        FileHeader(const char (&magic)[8], std::uint32_t version) noexcept :
+                version(version),
+                byteOrder(BYTE_ORDER_MARK)
+        {
+            std::copy(std::begin(magic), std::end(magic), this->magic);
+        }
+
+        /**
+         * Terminate the program if this is not the header of a supported file.
+         *
+         * @param magic Expected magic bytes.
+         * @param version Supported version.
+         * @param path File name for the messages.
+         * @param kind Description of the file for the messages.
+         */
+        void check(const char (&magic)[8], std::uint32_t version, const std::string &path, const char *kind) const
+        {
+            CHECK(std::equal(std::begin(magic), std::end(magic), this->magic)) << path << " is not " << kind << ".";
+            CHECK_EQ(this->version, version) << "Unsupported version of " << path;
+            CHECK_EQ(byteOrder, BYTE_ORDER_MARK) << path << " was written with a different byte order.";
+        }
+    };
+
+    template<class T>
+    inline void writeValue(std::ostream &out, const T &value)
+    {
+        out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    template<class T>
+    inline void writeArray(std::ostream &out, const std::vector<T> &values)
+    {
+        out.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+    }
+
+    template<class T>
+    inline T readValue(std::istream &in)
+    {
+        T value;
+        in.read(reinterpret_cast<char *>(&value), sizeof(T));
+        return value;
+    }
+
+    template<class T>
+    inline void readArray(std::istream &in, std::vector<T> &values, std::size_t size)
+    {
+        values.resize(size);
+        in.read(reinterpret_cast<char *>(values.data()), size * sizeof(T));
+    }
+}
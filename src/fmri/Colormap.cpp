@@ -0,0 +1,186 @@
+#include "Colormap.hpp"
+
+using namespace fmri;
+
+static const char COLORMAP_VERTEX_SHADER[] = R"glsl(
+#version 130
+
+uniform int scale;
+uniform bool unpack;
+uniform sampler1D transforms;
+
+out float saturation;
+out float magnitude;
+
+void main()
+{
+    float value = gl_MultiTexCoord0.s;
+    magnitude = abs(value);
+    if (scale == 1) {
+        // Same as FlatLayerVisualisation::intensityFunction().
+        saturation = magnitude > 0 ? sign(value) * clamp(1 + log(magnitude) / 10, 0, 1) : 0;
+    } else {
+        saturation = clamp(value, -1, 1);
+    }
+    vec4 vertex = gl_Vertex;
+    if (unpack) {
+        vec4 transform = texelFetch(transforms, int(gl_Vertex.w), 0);
+        vertex = vec4(transform.xyz + transform.w * gl_Vertex.xyz, 1);
+    }
+    gl_Position = gl_ModelViewProjectionMatrix * vertex;
+    gl_FrontColor = gl_Color;
+}
+)glsl";
+
+static const char COLORMAP_FRAGMENT_SHADER[] = R"glsl(
+#version 130
+
+uniform sampler1D colormap;
+uniform float alpha;
+uniform float threshold;
+uniform int style;
+
+in float saturation;
+in float magnitude;
+
+void main()
+{
+    if (magnitude <= threshold) {
+        discard;
+    }
+
+    float coverage = 1;
+    if (style == 2) {
+        float distance = 2 * length(gl_PointCoord - vec2(0.5));
+        coverage = 1 - smoothstep(1 - fwidth(distance), 1, distance);
+    }
+
+    // Entries are at texel centres, from -1 to 1.
+    float size = textureSize(colormap, 0);
+    float position = (0.5 + (size - 1) * (0.5 + 0.5 * saturation)) / size;
+    vec4 color = style == 1 ? vec4(0, 0, 0, 1) : style == 3 ? gl_Color : vec4(texture(colormap, position).rgb, 1);
+    gl_FragColor = vec4(color.rgb, color.a * alpha * coverage);
+}
+)glsl";
+
+Colormap::Colormap() noexcept :
+        negative(NEGATIVE_COLOR),
+        neutral(NEUTRAL_COLOR),
+        positive(POSITIVE_COLOR),
+        changed(true),
+        texture(0),
+        scaleLocation(-1),
+        alphaLocation(-1),
+        thresholdLocation(-1),
+        styleLocation(-1),
+        unpackLocation(-1)
+{
+}
+
+Colormap &Colormap::instance()
+{
+    static Colormap colormap;
+    return colormap;
+}
+
+void Colormap::setColors(const Color &negative, const Color &neutral, const Color &positive)
+{
+    this->negative = negative;
+    this->neutral = neutral;
+    this->positive = positive;
+    changed = true;
+}
+
+Color Colormap::color(float saturation) const
+{
+    auto result = saturation > 0
+            ? interpolate(saturation, positive, neutral)
+            : interpolate(-saturation, negative, neutral);
+    if constexpr (alphaEnabled()) {
+        result[3] = 1;
+    }
+
+    return result;
+}
+
+void Colormap::use(Scale scale, float alpha, float threshold, Style style)
+{
+    // Compiled on first use, since it needs a current context.
+    if (!program) {
+        program = ShaderProgram(COLORMAP_VERTEX_SHADER, COLORMAP_FRAGMENT_SHADER);
+        scaleLocation = program.uniform("scale");
+        alphaLocation = program.uniform("alpha");
+        thresholdLocation = program.uniform("threshold");
+        styleLocation = program.uniform("style");
+        unpackLocation = program.uniform("unpack");
+        program.use();
+        glUniform1i(program.uniform("colormap"), 0);
+        glUniform1i(program.uniform("transforms"), 1);
+    }
+    if (changed) {
+        upload();
+    }
+
+    program.use();
+    glUniform1i(scaleLocation, static_cast<GLint>(scale));
+    glUniform1f(alphaLocation, alpha);
+    glUniform1f(thresholdLocation, threshold);
+    glUniform1i(styleLocation, static_cast<GLint>(style));
+    glUniform1i(unpackLocation, false);
+    glBindTexture(GL_TEXTURE_1D, texture);
+    if (style == Style::POINTS) {
+        // Provides gl_PointCoord.
+        glEnable(GL_POINT_SPRITE);
+    }
+}
+
+void Colormap::usePacked(GLuint transforms)
+{
+    glUniform1i(unpackLocation, true);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_1D, transforms);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void Colormap::release()
+{
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_1D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glDisable(GL_POINT_SPRITE);
+    glBindTexture(GL_TEXTURE_1D, 0);
+    glUseProgram(0);
+}
+
+void Colormap::glUnload()
+{
+    program = ShaderProgram();
+    if (texture != 0) {
+        glDeleteTextures(1, &texture);
+        texture = 0;
+    }
+    changed = true;
+}
+
+void Colormap::upload()
+{
+    std::array<PackedColor, SIZE> lookup;
+    for (auto i = 0; i < SIZE; ++i) {
+        lookup[i] = packColor(color(2.f * i / (SIZE - 1) - 1));
+    }
+
+    if (texture == 0) {
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_1D, texture);
+        glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA8, SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, lookup.data());
+    } else {
+        glBindTexture(GL_TEXTURE_1D, texture);
+        glTexSubImage1D(GL_TEXTURE_1D, 0, 0, SIZE, GL_RGBA, GL_UNSIGNED_BYTE, lookup.data());
+    }
+    glBindTexture(GL_TEXTURE_1D, 0);
+
+    changed = false;
+}
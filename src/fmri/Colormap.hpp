@@ -0,0 +1,105 @@
+#pragma once
+
+#include <GL/gl.h>
+#include "ShaderProgram.hpp"
+#include "utils.hpp"
+
+namespace fmri
+{
+    /**
+     * Maps activations to colours on the GPU.
+     *
+     * Drawables keep their activations rather than colours, as the first
+     * texture coordinate of every vertex. A shader maps those through a
+     * 1D lookup texture from the negative to the neutral to the positive
+     * colour. Colours, opacity and the activation threshold are uniforms
+     * or a tiny texture, so changing them does not rebuild anything.
+     *
+     * All methods but color() should be called from the thread owning the GL context.
+     */
+    class Colormap
+    {
+    public:
+        /**
+         * How activations are turned into a position in the colormap.
+         */
+        enum class Scale
+        {
+            // Values are already in [-1, 1].
+            LINEAR,
+            // Values are relative to the largest in the layer, see FlatLayerVisualisation::intensityFunction().
+            LOGARITHMIC,
+        };
+
+        enum class Style
+        {
+            FILL,
+            // Black, for wireframes.
+            OUTLINE,
+            // Round points, like GL_POINT_SMOOTH.
+            POINTS,
+            // The current colour, for lines that are not coloured by activation.
+            SOLID,
+        };
+
+        static Colormap& instance();
+
+        /**
+         * Change the colours, taking effect on the next frame.
+         */
+        void setColors(const Color& negative, const Color& neutral, const Color& positive);
+
+        /**
+         * @param saturation Position in the colormap, in [-1, 1].
+         * @return The colour at that position, opaque.
+         */
+        Color color(float saturation) const;
+
+        /**
+         * Draw with the colormap until release() is called.
+         *
+         * @param scale Scale of the activations.
+         * @param alpha Opacity.
+         * @param threshold Vertices with activations no larger in magnitude are not drawn. Negative to draw everything.
+         * @param style
+         */
+        void use(Scale scale, float alpha, float threshold = -1, Style style = Style::FILL);
+        /**
+         * Take vertices packed as by DrawList, until the next use().
+         *
+         * Their x, y and z are fixed point, and w selects the transform
+         * that moves them into place.
+         *
+         * @param transforms 1D RGBA32F texture of transforms, an origin and a step size per texel.
+         */
+        void usePacked(GLuint transforms);
+        void release();
+
+        /**
+         * Release the program and lookup texture, before the context is destroyed.
+         *
+         * Both are created again when the colormap is next used.
+         */
+        void glUnload();
+
+    private:
+        static constexpr int SIZE = 256;
+
+        Color negative;
+        Color neutral;
+        Color positive;
+        bool changed;
+
+        ShaderProgram program;
+        GLuint texture;
+        GLint scaleLocation;
+        GLint alphaLocation;
+        GLint thresholdLocation;
+        GLint styleLocation;
+        GLint unpackLocation;
+
+        Colormap() noexcept;
+
+        void upload();
+    };
+}
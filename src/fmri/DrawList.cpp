@@ -0,0 +1,314 @@
+#include <glog/logging.h>
+#include <limits>
+#include <utility>
+#include "Colormap.hpp"
+#include "DrawList.hpp"
+#include "FrameProfiler.hpp"
+#include "glutils.hpp"
+#include "visualisations.hpp"
+
+using namespace fmri;
+
+static void appendIndices(const IndexBuffer& indices, std::size_t base, std::vector<std::uint32_t>& destination)
+{
+    destination.reserve(destination.size() + indices.size());
+    for (auto i = 0u; i < indices.size(); ++i) {
+        destination.push_back(base + indices.at(i));
+    }
+}
+
+DrawList::DrawList(DrawList &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+DrawList &DrawList::operator=(DrawList &&other) noexcept
+{
+    if (this != &other) {
+        glUnload();
+        commands = std::move(other.commands);
+        layers = std::move(other.layers);
+        paths = std::move(other.paths);
+        positionBuffer = std::exchange(other.positionBuffer, 0);
+        valueBuffer = std::exchange(other.valueBuffer, 0);
+        indexBuffer = std::exchange(other.indexBuffer, 0);
+        transformTexture = std::exchange(other.transformTexture, 0);
+        indexType = other.indexType;
+        bytes = other.bytes;
+        staging = std::move(other.staging);
+    }
+
+    return *this;
+}
+
+DrawList::~DrawList()
+{
+    glUnload();
+}
+
+void DrawList::glLoad(const InputVisualisation &input)
+{
+    // Buffers of an earlier upload are kept, so recompiling respecifies them in place.
+    commands = {};
+    staging = std::make_unique<Staging>();
+
+    const auto numLayers = input.layers.size();
+    layers.resize(numLayers);
+    paths.resize(numLayers);
+
+    for (auto i = 0u; i < numLayers; ++i) {
+        auto& [layer, animation] = input.layers[i];
+        staging->origin = layerOrigin(i, numLayers);
+
+        std::array<std::size_t, NUM_PASSES> starts;
+        for (auto pass = 0; pass < NUM_PASSES; ++pass) {
+            starts[pass] = staging->indices[pass].size();
+        }
+
+        layers[i] = layer->compile(*this);
+        paths[i] = animation && animation->compilePaths(*this);
+
+        for (auto pass = 0; pass < NUM_PASSES; ++pass) {
+            staging->ranges[pass].emplace_back(starts[pass], staging->indices[pass].size() - starts[pass]);
+        }
+    }
+
+    upload();
+    staging.reset();
+}
+
+/**
+ * Append vertices to a merged buffer, with a new transform to the origin of the current layer.
+ *
+ * @return Index of the first vertex.
+ */
+std::size_t DrawList::appendPositions(const PackedPositions &positions, std::vector<std::int16_t> &destination)
+{
+    const auto transform = staging->transforms.size() / 4;
+    CHECK_LE(transform, std::numeric_limits<std::int16_t>::max()) << "Too many transforms for a draw list.";
+    const auto& origin = staging->origin;
+    staging->transforms.insert(staging->transforms.end(), {origin[0], origin[1], origin[2], positions.step()});
+
+    const auto& coordinates = positions.coordinates();
+    const auto base = destination.size() / 4;
+    destination.reserve(destination.size() + coordinates.size() / 3 * 4);
+    for (auto i = 0u; i < coordinates.size(); i += 3) {
+        destination.insert(destination.end(), {coordinates[i], coordinates[i + 1], coordinates[i + 2],
+                                               static_cast<std::int16_t>(transform)});
+    }
+
+    return base;
+}
+
+void DrawList::upload()
+{
+    const auto surfaceVertices = staging->surfacePositions.size() / 4;
+    const auto vertices = surfaceVertices + staging->pathPositions.size() / 4;
+    CHECK_EQ(staging->values.size(), surfaceVertices) << "Every surface vertex needs an activation.";
+
+    // Paths follow the surfaces in the merged vertex buffer.
+    for (auto& index : staging->indices[PATHS]) {
+        index += surfaceVertices;
+    }
+
+    std::vector<std::uint32_t> indices;
+    std::array<std::size_t, NUM_PASSES> passStarts;
+    for (auto pass = 0; pass < NUM_PASSES; ++pass) {
+        passStarts[pass] = indices.size();
+        indices.insert(indices.end(), staging->indices[pass].begin(), staging->indices[pass].end());
+    }
+
+    if (indices.empty()) {
+        deleteBuffers();
+        return;
+    }
+
+    if (positionBuffer == 0) {
+        GLuint buffers[3];
+        glGenBuffers(3, buffers);
+        positionBuffer = buffers[0];
+        valueBuffer = buffers[1];
+        indexBuffer = buffers[2];
+        glGenTextures(1, &transformTexture);
+    }
+
+    const auto positionSize = 4 * sizeof(std::int16_t);
+    glBindBuffer(GL_ARRAY_BUFFER, positionBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertices * positionSize, nullptr, GL_STATIC_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, surfaceVertices * positionSize, staging->surfacePositions.data());
+    glBufferSubData(GL_ARRAY_BUFFER, surfaceVertices * positionSize, (vertices - surfaceVertices) * positionSize,
+                    staging->pathPositions.data());
+
+    glBindBuffer(GL_ARRAY_BUFFER, valueBuffer);
+    glBufferData(GL_ARRAY_BUFFER, staging->values.size() * sizeof(float), staging->values.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    const auto transforms = staging->transforms.size() / 4;
+    glBindTexture(GL_TEXTURE_1D, transformTexture);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA32F, transforms, 0, GL_RGBA, GL_FLOAT, staging->transforms.data());
+    glBindTexture(GL_TEXTURE_1D, 0);
+
+    std::size_t indexSize;
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    if (vertices <= std::numeric_limits<std::uint16_t>::max()) {
+        const std::vector<std::uint16_t> shortIndices(indices.begin(), indices.end());
+        indexType = GL_UNSIGNED_SHORT;
+        indexSize = sizeof(std::uint16_t);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * indexSize, shortIndices.data(), GL_STATIC_DRAW);
+    } else {
+        indexType = GL_UNSIGNED_INT;
+        indexSize = sizeof(std::uint32_t);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * indexSize, indices.data(), GL_STATIC_DRAW);
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    bytes = vertices * positionSize + staging->values.size() * sizeof(float) + indices.size() * indexSize
+            + staging->transforms.size() * sizeof(float);
+
+    for (auto pass = 0; pass < NUM_PASSES; ++pass) {
+        auto& forward = commands[pass][false];
+        auto& reverse = commands[pass][true];
+        for (auto [start, length] : staging->ranges[pass]) {
+            if (length == 0) {
+                continue;
+            }
+            forward.counts.push_back(length);
+            forward.offsets.push_back(reinterpret_cast<const void *>((passStarts[pass] + start) * indexSize));
+            forward.vertices += length;
+        }
+
+        reverse.counts.assign(forward.counts.rbegin(), forward.counts.rend());
+        reverse.offsets.assign(forward.offsets.rbegin(), forward.offsets.rend());
+        reverse.vertices = forward.vertices;
+    }
+}
+
+void DrawList::glUnload()
+{
+    deleteBuffers();
+    commands = {};
+    layers.clear();
+    paths.clear();
+}
+
+void DrawList::deleteBuffers()
+{
+    if (positionBuffer != 0) {
+        const GLuint buffers[] = {positionBuffer, valueBuffer, indexBuffer};
+        glDeleteBuffers(3, buffers);
+        glDeleteTextures(1, &transformTexture);
+        positionBuffer = valueBuffer = indexBuffer = transformTexture = 0;
+    }
+}
+
+std::size_t DrawList::glMemoryUsage() const
+{
+    return bytes;
+}
+
+void DrawList::addSurfaces(const PackedPositions &positions, const std::vector<float> &values,
+                           const IndexBuffer &indices, const IndexBuffer &activeIndices)
+{
+    const auto base = appendPositions(positions, staging->surfacePositions);
+    staging->values.insert(staging->values.end(), values.begin(), values.end());
+    appendIndices(indices, base, staging->indices[SURFACES]);
+    appendIndices(activeIndices, base, staging->indices[ACTIVE_SURFACES]);
+}
+
+void DrawList::addPaths(const PackedPositions &positions, const IndexBuffer &indices)
+{
+    const auto base = appendPositions(positions, staging->pathPositions);
+    appendIndices(indices, base, staging->indices[PATHS]);
+}
+
+void DrawList::addPaths(const std::vector<float> &positions, const IndexBuffer &indices)
+{
+    addPaths(PackedPositions(positions), indices);
+}
+
+bool DrawList::coversLayer(std::size_t layer) const
+{
+    return layer < layers.size() && layers[layer];
+}
+
+bool DrawList::coversPaths(std::size_t layer) const
+{
+    return layer < paths.size() && paths[layer];
+}
+
+void DrawList::drawSurfaces(bool reverse, float threshold, float alpha) const
+{
+    // Inactive nodes are never above the threshold.
+    const auto& pass = commands[threshold >= 0 ? ACTIVE_SURFACES : SURFACES][reverse];
+    if (pass.counts.empty()) {
+        return;
+    }
+
+    auto &colormap = Colormap::instance();
+    glDepthMask(GL_FALSE);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, positionBuffer);
+    glVertexPointer(4, GL_SHORT, 0, nullptr);
+    glBindBuffer(GL_ARRAY_BUFFER, valueBuffer);
+    glTexCoordPointer(1, GL_FLOAT, 0, nullptr);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    colormap.use(Colormap::Scale::LOGARITHMIC, alpha, threshold);
+    colormap.usePacked(transformTexture);
+    submit(pass, GL_TRIANGLES);
+
+    // Now draw wireframe
+    colormap.use(Colormap::Scale::LOGARITHMIC, alpha, threshold, Colormap::Style::OUTLINE);
+    colormap.usePacked(transformTexture);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    submit(pass, GL_TRIANGLES);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    colormap.release();
+
+    // Other drawables use client side arrays.
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDepthMask(GL_TRUE);
+}
+
+void DrawList::drawPaths(bool reverse, const Color &color) const
+{
+    const auto& pass = commands[PATHS][reverse];
+    if (pass.counts.empty()) {
+        return;
+    }
+
+    // The colormap shader unpacks the positions, but paths are a single colour.
+    auto &colormap = Colormap::instance();
+    setGlColor(color);
+    glDepthMask(GL_FALSE);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, positionBuffer);
+    glVertexPointer(4, GL_SHORT, 0, nullptr);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    colormap.use(Colormap::Scale::LINEAR, 1, -1, Colormap::Style::SOLID);
+    colormap.usePacked(transformTexture);
+    submit(pass, GL_LINES);
+    colormap.release();
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDepthMask(GL_TRUE);
+}
+
+void DrawList::submit(const Commands &pass, GLenum mode) const
+{
+    glMultiDrawElements(mode, pass.counts.data(), indexType, pass.offsets.data(), pass.counts.size());
+    FrameProfiler::instance().countDraw(pass.vertices);
+}
+
+std::array<float, 3> DrawList::layerOrigin(std::size_t layer, std::size_t layers)
+{
+    // The layer is centered on its position, and drawLayerName() moves it back.
+    return {LAYER_X_OFFSET * (layer - layers / 2.f), 0, -10};
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <GL/gl.h>
+#include "utils.hpp"
+#include "VertexBuffers.hpp"
+
+namespace fmri
+{
+    struct InputVisualisation;
+
+    /**
+     * Static geometry of a whole input, drawn with one multi-draw call per pass.
+     *
+     * When uploaded, every drawable of the input may add its static,
+     * untextured geometry. The geometry of all layers is merged into
+     * shared buffers, with a range of indices per layer. The ranges are
+     * kept in both directions, so the layers are drawn back-to-front from
+     * either side of the network.
+     *
+     * Positions stay in the fixed point format of PackedPositions. Every
+     * vertex carries the index of a transform, the origin of its layer and
+     * its step size, which the colormap shader applies. That takes the
+     * place of the per-layer translation, so a whole pass stays one call.
+     *
+     * Textured and animated drawables are not compiled, and are still
+     * drawn individually, after the compiled geometry. Since that is
+     * translucent, it does not write depth, so it never hides what is
+     * drawn later.
+     */
+    class DrawList
+    {
+    public:
+        DrawList() = default;
+        DrawList(const DrawList&) = delete;
+        DrawList(DrawList&& other) noexcept;
+        DrawList& operator=(DrawList&& other) noexcept;
+        ~DrawList();
+
+        /**
+         * Compile the geometry of an input and upload it.
+         *
+         * If the list was loaded before, its buffers are reused.
+         *
+         * @param input Input to compile. The list covers its layers by index.
+         */
+        void glLoad(const InputVisualisation& input);
+        void glUnload();
+
+        /**
+         * @return Bytes held on the GPU when loaded, 0 if never loaded.
+         */
+        std::size_t glMemoryUsage() const;
+
+        /**
+         * Add triangles coloured by activation, drawn filled and as wireframe.
+         *
+         * @param positions Vertices, relative to the origin of the current layer.
+         * @param values One activation per vertex, relative to the largest in the layer.
+         * @param indices Triangles drawn normally.
+         * @param activeIndices Triangles drawn when only activated nodes are shown.
+         */
+        void addSurfaces(const PackedPositions& positions, const std::vector<float>& values,
+                         const IndexBuffer& indices, const IndexBuffer& activeIndices);
+        /**
+         * Add lines, drawn in the path colour.
+         *
+         * @param positions Vertices, relative to the origin of the current layer.
+         * @param indices Pairs of vertices to connect.
+         */
+        void addPaths(const PackedPositions& positions, const IndexBuffer& indices);
+        void addPaths(const std::vector<float>& positions, const IndexBuffer& indices);
+
+        /**
+         * @return Whether the visualisation of a layer is drawn by drawSurfaces().
+         */
+        bool coversLayer(std::size_t layer) const;
+        /**
+         * @return Whether the interaction paths of a layer are drawn by drawPaths().
+         */
+        bool coversPaths(std::size_t layer) const;
+
+        /**
+         * @param reverse Draw from the last layer to the first.
+         * @param threshold Only draw nodes with larger relative activations, negative to draw all.
+         * @param alpha Opacity.
+         */
+        void drawSurfaces(bool reverse, float threshold, float alpha) const;
+        void drawPaths(bool reverse, const Color& color) const;
+
+        /**
+         * Position of the nodes of a layer in the scene.
+         *
+         * @param layer Index of the layer.
+         * @param layers Number of layers in the scene.
+         */
+        static std::array<float, 3> layerOrigin(std::size_t layer, std::size_t layers);
+
+    private:
+        enum Pass
+        {
+            SURFACES,
+            ACTIVE_SURFACES,
+            PATHS,
+            NUM_PASSES
+        };
+
+        // Arguments for a single glMultiDrawElements() call.
+        struct Commands
+        {
+            std::vector<GLsizei> counts;
+            std::vector<const void*> offsets;
+            std::size_t vertices = 0;
+        };
+
+        // Merged geometry, only kept while compiling.
+        struct Staging
+        {
+            std::array<float, 3> origin;
+            // Four components per vertex, the last being the index of its transform.
+            std::vector<std::int16_t> surfacePositions;
+            std::vector<float> values;
+            std::vector<std::int16_t> pathPositions;
+            // Origin and step size of every call that added positions.
+            std::vector<float> transforms;
+            std::array<std::vector<std::uint32_t>, NUM_PASSES> indices;
+            // Start and length in the indices of a pass, for every layer.
+            std::array<std::vector<std::pair<std::size_t, std::size_t>>, NUM_PASSES> ranges;
+        };
+
+        // Forward and reverse commands for every pass.
+        std::array<std::array<Commands, 2>, NUM_PASSES> commands;
+        std::vector<bool> layers;
+        std::vector<bool> paths;
+
+        GLuint positionBuffer = 0;
+        GLuint valueBuffer = 0;
+        GLuint indexBuffer = 0;
+        GLuint transformTexture = 0;
+        GLenum indexType = GL_UNSIGNED_INT;
+        std::size_t bytes = 0;
+
+        std::unique_ptr<Staging> staging;
+
+        std::size_t appendPositions(const PackedPositions& positions, std::vector<std::int16_t>& destination);
+        void upload();
+        void deleteBuffers();
+        void submit(const Commands& pass, GLenum mode) const;
+    };
+}
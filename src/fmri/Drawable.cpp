@@ -1,24 +1,40 @@
 #include "Drawable.hpp"
 #include "RenderingState.hpp"
 
-void fmri::Drawable::patchTransparency()
+void fmri::Drawable::glLoad()
 {
-    if constexpr (!alphaEnabled()) {
-        // Not compiling with alpha support
-        return;
-    }
+    // Do nothing
+}
 
-    const auto alpha = getAlpha();
-    const auto end = colorBuffer.end();
+void fmri::Drawable::glUnload()
+{
+    // Do nothing
+}
 
-    for (auto it = colorBuffer.begin(); it != end; ++it) {
-        (*it)[3] = alpha;
-    }
+void fmri::Drawable::glReplace(Drawable &previous)
+{
+    previous.glUnload();
+    glLoad();
 }
 
-void fmri::Drawable::glLoad()
+std::size_t fmri::Drawable::glMemoryUsage() const
 {
-    // Do nothing
+    return 0;
+}
+
+std::size_t fmri::Drawable::vertexBytes() const
+{
+    return bytesOf(valueBuffer);
+}
+
+std::size_t fmri::Drawable::indexBytes() const
+{
+    return 0;
+}
+
+bool fmri::Drawable::compile(DrawList &) const
+{
+    return false;
 }
 
 void fmri::Drawable::handleBrainMode(std::vector<float> &vertices)
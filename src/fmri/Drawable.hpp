@@ -5,6 +5,7 @@
 
 namespace fmri
 {
+    class DrawList;
 
     /**
      * Base class for anything to be drawn to the screen.
@@ -15,7 +16,6 @@ namespace fmri
         virtual ~Drawable() = default;
 
         virtual void draw(float time) = 0;
-        virtual void patchTransparency();
         /**
          * Do any GL related initialization.
          *
@@ -25,15 +25,60 @@ namespace fmri
          * The default implementation does nothing.
          */
         virtual void glLoad();
+        /**
+         * Release any GL resources acquired by glLoad().
+         *
+         * Enough state must be kept to call glLoad() again later. The
+         * default implementation does nothing.
+         */
+        virtual void glUnload();
+        /**
+         * Upload in place of the drawable this one replaces.
+         *
+         * Drawables that replace one of the same kind and size may take
+         * over its GPU resources instead of allocating new ones. The
+         * previous drawable is left unloaded. The default implementation
+         * unloads it and calls glLoad().
+         *
+         * @param previous Loaded drawable being replaced.
+         */
+        virtual void glReplace(Drawable& previous);
+        /**
+         * @return Estimated number of bytes held on the GPU after glLoad().
+         */
+        virtual std::size_t glMemoryUsage() const;
+        /**
+         * @return Number of bytes of vertex data (positions, activations and texture coordinates) kept for drawing.
+         */
+        virtual std::size_t vertexBytes() const;
+        /**
+         * @return Number of bytes of index data kept for drawing.
+         */
+        virtual std::size_t indexBytes() const;
+        /**
+         * Add static geometry to the draw list of the input.
+         *
+         * The default implementation adds nothing.
+         *
+         * @return Whether the list replaces draw().
+         */
+        virtual bool compile(DrawList& list) const;
 
     protected:
         static constexpr auto BRAIN_SIZE = 15;
 
-        std::vector<Color> colorBuffer;
+        // Activation of every vertex, coloured by the Colormap.
+        std::vector<float> valueBuffer;
 
         virtual float getAlpha() = 0;
         virtual void handleBrainMode(std::vector<float>& vertices);
         static bool brainModeEnabled();
+
+        template<class T>
+        static std::size_t bytesOf(const std::vector<T>& buffer)
+        {
+            return buffer.size() * sizeof(T);
+        }
     };
 
 }
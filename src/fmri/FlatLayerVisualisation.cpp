@@ -1,31 +1,18 @@
 #include <glog/logging.h>
 #include <GL/gl.h>
 
+#include "Colormap.hpp"
+#include "DrawList.hpp"
 #include "FlatLayerVisualisation.hpp"
 #include "Range.hpp"
 #include "RenderingState.hpp"
+#include "FrameProfiler.hpp"
 
 using namespace fmri;
 
-static inline void computeColor(float intensity, float limit, Color& destination)
-{
-    const float saturation = FlatLayerVisualisation::intensityFunction(intensity, limit);
-    if (saturation > 0) {
-        destination = interpolate(saturation, POSITIVE_COLOR, NEUTRAL_COLOR);
-    } else {
-        destination = interpolate(-saturation, NEGATIVE_COLOR, NEUTRAL_COLOR);
-    }
-    if constexpr (alphaEnabled()) {
-        // We have an alpha channel, set it to 1.
-        destination[3] = 1;
-    }
-}
-
 FlatLayerVisualisation::FlatLayerVisualisation(const LayerData &layer, Ordering ordering) :
         LayerVisualisation(layer.numEntries()),
-        ordering(ordering),
-        vertexBuffer(layer.numEntries() * NODE_FACES.size()),
-        indexBuffer(layer.numEntries() * NODE_FACES.size())
+        ordering(ordering)
 {
     auto &shape = layer.shape();
     CHECK_EQ(shape.size(), 2) << "layer should be flat!\n";
@@ -40,14 +27,20 @@ FlatLayerVisualisation::FlatLayerVisualisation(const LayerData &layer, Ordering
 
     auto scalingMax = std::max(abs(*minElem), abs(*maxElem));
 
-    auto colorPos = std::back_inserter(colorBuffer);
-    auto indexPos = indexBuffer.begin();
+    // Built at full precision, then packed once brain mode has been applied.
+    std::vector<float> vertices(layer.numEntries() * NODE_SHAPE.size());
+    std::vector<unsigned int> indices(layer.numEntries() * NODE_FACES.size());
+    std::vector<unsigned int> activeIndices;
+
+    // Activations are kept relative to the largest, the colormap takes care of the rest.
+    valueBuffer.reserve(layer.numEntries() * VERTICES_PER_NODE);
+    auto valuePos = std::back_inserter(valueBuffer);
+    auto indexPos = indices.begin();
 
     for (int i : Range(limit)) {
-        setVertexPositions(i, vertexBuffer.data() + NODE_FACES.size() * i);
-        Color nodeColor;
-        computeColor(data[i], scalingMax, nodeColor);
-        colorPos = std::fill_n(colorPos, NODE_FACES.size() / 3, nodeColor);
+        setVertexPositions(i, vertices.data() + NODE_SHAPE.size() * i);
+        const auto value = scalingMax > 0 ? data[i] / scalingMax : 0;
+        valuePos = std::fill_n(valuePos, VERTICES_PER_NODE, value);
 
         auto newIndexPos = std::copy(std::begin(NODE_FACES), std::end(NODE_FACES), indexPos);
         std::transform(indexPos, newIndexPos, indexPos, [i](auto x) { return x + i * VERTICES_PER_NODE;});
@@ -57,35 +50,48 @@ FlatLayerVisualisation::FlatLayerVisualisation(const LayerData &layer, Ordering
     // Compute which nodes are active, add those to the active indices
     for (auto i : Range(limit)) {
         if (abs(data[i]) > EPSILON) {
-            std::copy_n(&indexBuffer[NODE_FACES.size() * i], NODE_FACES.size(), std::back_inserter(activeIndexBuffer));
+            std::copy_n(&indices[NODE_FACES.size() * i], NODE_FACES.size(), std::back_inserter(activeIndices));
         }
     }
 
-    assert(indexPos == indexBuffer.end());
-    patchTransparency();
-    handleBrainMode(vertexBuffer);
+    assert(indexPos == indices.end());
+    handleBrainMode(vertices);
     handleBrainMode(nodePositions_);
+
+    vertexBuffer = PackedPositions(vertices);
+    indexBuffer = IndexBuffer(indices);
+    activeIndexBuffer = IndexBuffer(activeIndices);
 }
 
 void FlatLayerVisualisation::draw(float)
 {
+    auto &colormap = Colormap::instance();
+    const auto threshold = RenderingState::instance().activationThreshold();
+    const auto alpha = getAlpha();
+
     glEnableClientState(GL_VERTEX_ARRAY);
-    glEnableClientState(GL_COLOR_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
 
-    const auto& indices = RenderingState::instance().renderActivatedOnly() ? activeIndexBuffer : indexBuffer;
+    // Inactive nodes are never above the threshold.
+    const auto& indices = threshold >= 0 ? activeIndexBuffer : indexBuffer;
 
-    glVertexPointer(3, GL_FLOAT, 0, vertexBuffer.data());
-    glColorPointer(std::tuple_size<Color>::value, GL_FLOAT, 0, colorBuffer.data());
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, indices.data());
-    glDisableClientState(GL_COLOR_ARRAY);
+    glPushMatrix();
+    vertexBuffer.bind();
+    glTexCoordPointer(1, GL_FLOAT, 0, valueBuffer.data());
+    colormap.use(Colormap::Scale::LOGARITHMIC, alpha, threshold);
+    indices.draw(GL_TRIANGLES);
+    FrameProfiler::instance().countDraw(indices.size());
 
     // Now draw wireframe
-    glColor4f(0, 0, 0, getAlpha());
+    colormap.use(Colormap::Scale::LOGARITHMIC, alpha, threshold, Colormap::Style::OUTLINE);
     glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, indices.data());
+    indices.draw(GL_TRIANGLES);
+    FrameProfiler::instance().countDraw(indices.size());
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    colormap.release();
+    glPopMatrix();
 
-
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
     glDisableClientState(GL_VERTEX_ARRAY);
 }
 
@@ -120,3 +126,19 @@ float FlatLayerVisualisation::intensityFunction(float f, float limit)
 
     return std::copysign(result, f);
 }
+
+std::size_t FlatLayerVisualisation::vertexBytes() const
+{
+    return Drawable::vertexBytes() + vertexBuffer.bytes();
+}
+
+std::size_t FlatLayerVisualisation::indexBytes() const
+{
+    return indexBuffer.bytes() + activeIndexBuffer.bytes();
+}
+
+bool FlatLayerVisualisation::compile(DrawList &list) const
+{
+    list.addSurfaces(vertexBuffer, valueBuffer, indexBuffer, activeIndexBuffer);
+    return true;
+}
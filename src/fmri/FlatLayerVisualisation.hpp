@@ -4,6 +4,7 @@
 
 #include "LayerData.hpp"
 #include "LayerVisualisation.hpp"
+#include "VertexBuffers.hpp"
 
 namespace fmri
 {
@@ -13,14 +14,17 @@ namespace fmri
         explicit FlatLayerVisualisation(const LayerData &layer, Ordering ordering);
 
         void draw(float time) override;
+        std::size_t vertexBytes() const override;
+        std::size_t indexBytes() const override;
+        bool compile(DrawList& list) const override;
 
         static float intensityFunction(float f, float limit);
 
     private:
         Ordering ordering;
-        std::vector<float> vertexBuffer;
-        std::vector<int> indexBuffer;
-        std::vector<int> activeIndexBuffer;
+        PackedPositions vertexBuffer;
+        IndexBuffer indexBuffer;
+        IndexBuffer activeIndexBuffer;
 
         static constexpr const std::array<float, 12> NODE_SHAPE = {
                 -0.5f, 0, 0.5f,
@@ -28,7 +32,7 @@ namespace fmri
                 0, 1, 0,
                 0.5f, 0, 0.5f
         };
-        static constexpr const std::array<int, 12> NODE_FACES = {
+        static constexpr const std::array<unsigned int, 12> NODE_FACES = {
                 0, 1, 2,
                 0, 1, 3,
                 0, 2, 3,
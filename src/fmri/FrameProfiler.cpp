@@ -0,0 +1,286 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <glog/logging.h>
+#include "FrameProfiler.hpp"
+
+using namespace fmri;
+
+FrameProfiler::Phase::Phase(const char *name) :
+        name(name),
+        start(clock::now())
+{
+}
+
+FrameProfiler::Phase::~Phase()
+{
+    FrameProfiler::instance().addPhase(name, clock::now() - start);
+}
+
+FrameProfiler::Section::Section(std::string_view layer, std::string_view kind) :
+        active(FrameProfiler::instance().enabled())
+{
+    if (active) {
+        std::string name(layer);
+        name += kind;
+        FrameProfiler::instance().beginGpuSection(std::move(name));
+        start = clock::now();
+    }
+}
+
+FrameProfiler::Section::~Section()
+{
+    if (active) {
+        auto &profiler = FrameProfiler::instance();
+        profiler.addSectionCpu(clock::now() - start);
+        profiler.endGpuSection();
+    }
+}
+
+FrameProfiler::FrameProfiler() noexcept :
+        enabled_(false),
+        gpuTimersSupported(false),
+        frameNumber(0),
+        drawCalls(0),
+        vertices(0),
+        lastDrawCalls(0),
+        lastVertices(0)
+{
+}
+
+FrameProfiler &FrameProfiler::instance()
+{
+    static FrameProfiler profiler;
+    return profiler;
+}
+
+void FrameProfiler::setEnabled(bool enabled)
+{
+    if (enabled && !enabled_) {
+        gpuTimersSupported = checkTimerQuerySupport();
+        LOG_IF(INFO, !gpuTimersSupported) << "GPU timer queries unavailable, only measuring CPU time.";
+    }
+
+    enabled_ = enabled;
+}
+
+bool FrameProfiler::enabled() const
+{
+    return enabled_;
+}
+
+void FrameProfiler::beginFrame()
+{
+    if (!enabled_) {
+        return;
+    }
+
+    ++frameNumber;
+    // Queries from this slot were issued QUERY_LATENCY frames ago and should be done by now.
+    collectQueries(pendingQueries[frameNumber % QUERY_LATENCY]);
+
+    drawCalls = 0;
+    vertices = 0;
+    currentPhases.clear();
+    currentSectionCpu.clear();
+    frameStart = clock::now();
+}
+
+void FrameProfiler::endFrame()
+{
+    if (!enabled_) {
+        return;
+    }
+
+    const auto smooth = [](float &average, float value) {
+        average += SMOOTHING * (value - average);
+    };
+
+    cpuHistory.push_back(toMillis(clock::now() - frameStart));
+    if (cpuHistory.size() > HISTORY_LENGTH) {
+        cpuHistory.pop_front();
+    }
+
+    for (auto&[name, time] : currentPhases) {
+        if (auto it = phases.find(name); it != phases.end()) {
+            smooth(it->second, time);
+        } else {
+            phases[name] = time;
+        }
+    }
+
+    // Only keep sections that are still being drawn.
+    std::map<std::string, SectionTimes> updatedSections;
+    for (auto&[name, time] : currentSectionCpu) {
+        if (auto it = sections.find(name); it != sections.end()) {
+            updatedSections[name] = it->second;
+            smooth(updatedSections[name].cpu, time);
+        } else {
+            updatedSections[name].cpu = time;
+        }
+    }
+    sections = std::move(updatedSections);
+
+    lastDrawCalls = drawCalls;
+    lastVertices = vertices;
+}
+
+void FrameProfiler::addPhase(const char *name, clock::duration time)
+{
+    if (enabled_) {
+        currentPhases[name] += toMillis(time);
+    }
+}
+
+void FrameProfiler::addSectionCpu(clock::duration time)
+{
+    currentSectionCpu[currentSection] += toMillis(time);
+}
+
+void FrameProfiler::beginGpuSection(std::string name)
+{
+    if (gpuTimersSupported) {
+        GLuint query;
+        if (freeQueries.empty()) {
+            glGenQueries(1, &query);
+        } else {
+            query = freeQueries.back();
+            freeQueries.pop_back();
+        }
+
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        pendingQueries[frameNumber % QUERY_LATENCY].push_back({name, query});
+    }
+
+    currentSection = std::move(name);
+}
+
+void FrameProfiler::endGpuSection()
+{
+    if (gpuTimersSupported) {
+        glEndQuery(GL_TIME_ELAPSED);
+    }
+}
+
+void FrameProfiler::collectQueries(std::vector<PendingQuery> &queries)
+{
+    if (queries.empty()) {
+        return;
+    }
+
+    std::map<std::string, float> frameTimes;
+    float total = 0;
+
+    for (auto &pending : queries) {
+        GLuint64 nanos;
+        glGetQueryObjectui64v(pending.query, GL_QUERY_RESULT, &nanos);
+        const float millis = nanos / 1e6f;
+        frameTimes[pending.section] += millis;
+        total += millis;
+        freeQueries.push_back(pending.query);
+    }
+    queries.clear();
+
+    for (auto&[name, time] : frameTimes) {
+        if (auto it = sections.find(name); it != sections.end()) {
+            it->second.gpu += SMOOTHING * (time - it->second.gpu);
+        }
+    }
+
+    gpuHistory.push_back(total);
+    if (gpuHistory.size() > HISTORY_LENGTH) {
+        gpuHistory.pop_front();
+    }
+}
+
+std::string FrameProfiler::report() const
+{
+    std::stringstream buffer;
+    buffer.precision(3);
+
+    buffer << "Frame: CPU " << (cpuHistory.empty() ? 0.f : cpuHistory.back()) << " ms";
+    if (gpuTimersSupported) {
+        buffer << ", GPU " << (gpuHistory.empty() ? 0.f : gpuHistory.back()) << " ms";
+    }
+    buffer << "\nDraw calls = " << lastDrawCalls << ", vertices = " << lastVertices << "\n";
+
+    buffer << "Phases:";
+    for (auto&[name, time] : phases) {
+        buffer << ' ' << name << ' ' << time << " ms";
+    }
+    buffer << '\n';
+
+    std::vector<std::pair<std::string, SectionTimes>> ranking(sections.begin(), sections.end());
+    const auto cost = [this](const SectionTimes &times) {
+        return gpuTimersSupported ? times.gpu : times.cpu;
+    };
+    const auto top = std::min(TOP_SECTIONS, ranking.size());
+    std::partial_sort(ranking.begin(), ranking.begin() + top, ranking.end(), [&](const auto &a, const auto &b) {
+        return cost(a.second) > cost(b.second);
+    });
+
+    buffer << "Most expensive (GPU / CPU ms):\n";
+    for (auto i = 0u; i < top; ++i) {
+        buffer << "  " << ranking[i].first << ' ' << ranking[i].second.gpu << " / " << ranking[i].second.cpu << '\n';
+    }
+
+    return buffer.str();
+}
+
+void FrameProfiler::drawGraph(int x, int y, int width, int height) const
+{
+    constexpr float budget = 1000.f / 60;
+
+    float scale = 2 * budget;
+    for (auto time : cpuHistory) {
+        scale = std::max(scale, time);
+    }
+    for (auto time : gpuHistory) {
+        scale = std::max(scale, time);
+    }
+
+    const auto toY = [=](float time) {
+        return y + height - height * time / scale;
+    };
+    const auto plot = [=](const std::deque<float> &history) {
+        glBegin(GL_LINE_STRIP);
+        for (auto i = 0u; i < history.size(); ++i) {
+            glVertex2f(x + width * static_cast<float>(i) / HISTORY_LENGTH, toY(history[i]));
+        }
+        glEnd();
+    };
+
+    glColor4f(0, 0, 0, 0.5);
+    glRectf(x, y, x + width, y + height);
+
+    // Frame budget for 60 FPS.
+    glColor3f(0.5, 0.5, 0.5);
+    glBegin(GL_LINES);
+    glVertex2f(x, toY(budget));
+    glVertex2f(x + width, toY(budget));
+    glEnd();
+
+    glColor3f(1, 1, 0);
+    plot(cpuHistory);
+    glColor3f(0, 1, 1);
+    plot(gpuHistory);
+}
+
+bool FrameProfiler::checkTimerQuerySupport()
+{
+    const auto version = reinterpret_cast<const char *>(glGetString(GL_VERSION));
+    int major = 0, minor = 0;
+    if (version != nullptr && std::sscanf(version, "%d.%d", &major, &minor) == 2
+        && (major > 3 || (major == 3 && minor >= 3))) {
+        return true;
+    }
+
+    const auto extensions = reinterpret_cast<const char *>(glGetString(GL_EXTENSIONS));
+    return extensions != nullptr && std::strstr(extensions, "GL_ARB_timer_query") != nullptr;
+}
+
+float FrameProfiler::toMillis(clock::duration d)
+{
+    return std::chrono::duration<float, std::milli>(d).count();
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <GL/gl.h>
+
+namespace fmri
+{
+    /**
+     * Singleton class collecting per-frame timing information.
+     *
+     * CPU time is measured per phase of the frame. GPU time is measured
+     * per layer using timer queries. Query results are read back a few
+     * frames later, to avoid stalling the pipeline.
+     *
+     * Nothing is measured unless the profiler is enabled.
+     */
+    class FrameProfiler
+    {
+    public:
+        typedef std::chrono::steady_clock clock;
+
+        /**
+         * Scoped CPU timer for a phase of the frame.
+         */
+        class Phase
+        {
+        public:
+            explicit Phase(const char *name);
+            ~Phase();
+
+        private:
+            const char *name;
+            clock::time_point start;
+        };
+
+        /**
+         * Scoped CPU and GPU timer for drawing a part of the scene.
+         *
+         * GPU timers cannot be nested.
+         */
+        class Section
+        {
+        public:
+            Section(std::string_view layer, std::string_view kind);
+            ~Section();
+
+        private:
+            bool active;
+            clock::time_point start;
+        };
+
+        static FrameProfiler& instance();
+
+        void setEnabled(bool enabled);
+        bool enabled() const;
+
+        void beginFrame();
+        void endFrame();
+
+        /**
+         * Record a draw call.
+         *
+         * @param vertices The number of vertices submitted.
+         */
+        void countDraw(std::size_t vertices)
+        {
+            if (enabled_) {
+                ++drawCalls;
+                this->vertices += vertices;
+            }
+        }
+
+        /**
+         * @return Text report of the most recent measurements.
+         */
+        std::string report() const;
+
+        /**
+         * Draw a graph of recent frame times, in window coordinates.
+         */
+        void drawGraph(int x, int y, int width, int height) const;
+
+    private:
+        static constexpr std::size_t QUERY_LATENCY = 4;
+        static constexpr std::size_t HISTORY_LENGTH = 120;
+        static constexpr std::size_t TOP_SECTIONS = 5;
+        // Weight of new measurements in the moving averages.
+        static constexpr float SMOOTHING = 0.1f;
+
+        struct PendingQuery
+        {
+            std::string section;
+            GLuint query;
+        };
+
+        struct SectionTimes
+        {
+            float cpu = 0;
+            float gpu = 0;
+        };
+
+        bool enabled_;
+        bool gpuTimersSupported;
+        std::size_t frameNumber;
+        clock::time_point frameStart;
+
+        std::array<std::vector<PendingQuery>, QUERY_LATENCY> pendingQueries;
+        std::vector<GLuint> freeQueries;
+
+        std::string currentSection;
+        std::map<std::string, float> currentSectionCpu;
+        std::map<std::string, float> currentPhases;
+        std::map<std::string, float> phases;
+        std::map<std::string, SectionTimes> sections;
+        std::size_t drawCalls;
+        std::size_t vertices;
+        std::size_t lastDrawCalls;
+        std::size_t lastVertices;
+
+        std::deque<float> cpuHistory;
+        std::deque<float> gpuHistory;
+
+        FrameProfiler() noexcept;
+
+        void addPhase(const char *name, clock::duration time);
+        void addSectionCpu(clock::duration time);
+        void beginGpuSection(std::string name);
+        void endGpuSection();
+        void collectQueries(std::vector<PendingQuery> &queries);
+
+        static bool checkTimerQuerySupport();
+        static float toMillis(clock::duration d);
+    };
+}
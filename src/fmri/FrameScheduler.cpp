@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <GL/glut.h>
+#include "FrameScheduler.hpp"
+
+using namespace fmri;
+using namespace std::chrono;
+
+FrameScheduler::FrameScheduler() noexcept :
+        notified(false),
+        backgroundWork(false),
+        animating(false),
+        visible(true),
+        paused_(false),
+        redrawRequested(false),
+        timerGeneration(0),
+        timerPending(false),
+        animationTime(0),
+        lastFrameStart(clock::now()),
+        frameStart(lastFrameStart),
+        frameDuration_(0)
+{
+}
+
+FrameScheduler &FrameScheduler::instance()
+{
+    static FrameScheduler scheduler;
+    return scheduler;
+}
+
+void FrameScheduler::notify()
+{
+    notified = true;
+}
+
+void FrameScheduler::setBackgroundWork(bool pending)
+{
+    backgroundWork = pending;
+    scheduleNext();
+}
+
+void FrameScheduler::setAnimating(bool animating)
+{
+    this->animating = animating;
+}
+
+void FrameScheduler::setVisible(bool visible)
+{
+    this->visible = visible;
+    if (visible) {
+        glutPostRedisplay();
+    }
+}
+
+void FrameScheduler::wakeAfter(clock::duration delay)
+{
+    const auto deadline = clock::now() + std::max(delay, clock::duration::zero());
+    if (!redrawRequested || deadline < redrawDeadline) {
+        redrawRequested = true;
+        redrawDeadline = deadline;
+    }
+
+    armTimer(redrawDeadline);
+}
+
+void FrameScheduler::beginFrame()
+{
+    frameStart = clock::now();
+    // Any outstanding request is satisfied by this frame.
+    redrawRequested = false;
+    if (!paused_) {
+        animationTime += std::min<clock::duration>(frameStart - lastFrameStart, MAX_STEP);
+    }
+    lastFrameStart = frameStart;
+}
+
+void FrameScheduler::endFrame()
+{
+    frameDuration_ = clock::now() - frameStart;
+    scheduleNext();
+}
+
+void FrameScheduler::togglePaused()
+{
+    paused_ = !paused_;
+}
+
+bool FrameScheduler::paused() const
+{
+    return paused_;
+}
+
+FrameScheduler::clock::duration FrameScheduler::frameDuration() const
+{
+    return frameDuration_;
+}
+
+void FrameScheduler::scheduleNext()
+{
+    if (animating && visible) {
+        // Subtract the time we already spent on this frame to keep a steady pace.
+        wakeAfter(duration_cast<clock::duration>(FRAME_INTERVAL) - frameDuration_);
+    } else if (backgroundWork) {
+        armTimer(clock::now() + POLL_INTERVAL);
+    }
+}
+
+void FrameScheduler::armTimer(clock::time_point deadline)
+{
+    if (timerPending && timerDeadline <= deadline) {
+        // Already waking up in time.
+        return;
+    }
+
+    timerPending = true;
+    timerDeadline = deadline;
+
+    const auto delay = std::max(deadline - clock::now(), clock::duration::zero());
+    const auto millis = static_cast<unsigned int>(ceil<milliseconds>(delay).count());
+    glutTimerFunc(millis, [](int generation) {
+        FrameScheduler::instance().handleTimer(generation);
+    }, ++timerGeneration);
+}
+
+void FrameScheduler::handleTimer(int generation)
+{
+    if (generation != timerGeneration) {
+        // Superseded by an earlier timer.
+        return;
+    }
+
+    timerPending = false;
+
+    // GLUT timers have millisecond resolution, allow for some rounding.
+    const auto dueBy = clock::now() + milliseconds(1);
+
+    if (notified.exchange(false) || (redrawRequested && redrawDeadline <= dueBy)) {
+        redrawRequested = false;
+        glutPostRedisplay();
+        return;
+    }
+
+    if (redrawRequested) {
+        armTimer(redrawDeadline);
+    }
+    if (backgroundWork) {
+        armTimer(clock::now() + POLL_INTERVAL);
+    }
+}
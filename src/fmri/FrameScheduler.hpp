@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+namespace fmri
+{
+    /**
+     * Singleton class deciding when frames should be drawn.
+     *
+     * Rather than redrawing from the GLUT idle function, frames are only
+     * drawn when something changed: user input, a running animation, or
+     * finished background work. When nothing changes, no timers are
+     * pending and the GLUT main loop simply blocks on window events.
+     *
+     * Apart from notify(), all methods should be called from the GLUT thread.
+     */
+    class FrameScheduler
+    {
+    public:
+        typedef std::chrono::steady_clock clock;
+
+        static FrameScheduler& instance();
+
+        /**
+         * Signal that background work has produced results.
+         *
+         * This method is thread-safe. The GLUT loop is woken up within
+         * one poll interval, as long as background work is pending.
+         */
+        void notify();
+
+        /**
+         * Set whether any background work is in progress.
+         *
+         * GLUT cannot be woken up from another thread, so while work is
+         * pending the loop checks for notifications on a slow timer.
+         */
+        void setBackgroundWork(bool pending);
+
+        /**
+         * Set whether the scene is currently changing by itself.
+         *
+         * When animating, frames are drawn continuously at the target rate.
+         */
+        void setAnimating(bool animating);
+
+        /**
+         * Set whether the window is visible. Invisible windows are never animated.
+         */
+        void setVisible(bool visible);
+
+        /**
+         * Ensure a frame is drawn no later than the given delay from now.
+         */
+        void wakeAfter(clock::duration delay);
+
+        /**
+         * Call at the start of every frame.
+         *
+         * Advances the animation clock by the measured time since the previous frame.
+         */
+        void beginFrame();
+
+        /**
+         * Call at the end of every frame. Schedules the next frame, if needed.
+         */
+        void endFrame();
+
+        /**
+         * Compute the step within a repeating animation.
+         *
+         * @param length The length of the animation.
+         * @return The position within the animation, 0..1.
+         */
+        template<class Duration>
+        float animationStep(const Duration &length) const
+        {
+            const auto modified_length = std::chrono::duration_cast<clock::duration>(length);
+            const auto step = animationTime % modified_length;
+
+            return static_cast<float>(step.count()) / static_cast<float>(modified_length.count());
+        }
+
+        void togglePaused();
+        bool paused() const;
+        /**
+         * @return The time spent drawing the last frame.
+         */
+        clock::duration frameDuration() const;
+
+    private:
+        static constexpr std::chrono::duration<double, std::ratio<1, 60>> FRAME_INTERVAL{1};
+        static constexpr std::chrono::milliseconds POLL_INTERVAL{50};
+        // Longest time the animation may advance in a single frame.
+        static constexpr std::chrono::milliseconds MAX_STEP{100};
+
+        std::atomic<bool> notified;
+        bool backgroundWork;
+        bool animating;
+        bool visible;
+        bool paused_;
+
+        bool redrawRequested;
+        clock::time_point redrawDeadline;
+
+        // Identifies the timer that is currently relevant; older timers are ignored.
+        int timerGeneration;
+        bool timerPending;
+        clock::time_point timerDeadline;
+
+        clock::duration animationTime;
+        clock::time_point lastFrameStart;
+        clock::time_point frameStart;
+        clock::duration frameDuration_;
+
+        FrameScheduler() noexcept;
+
+        void armTimer(clock::time_point deadline);
+        void scheduleNext();
+        void handleTimer(int generation);
+    };
+}
@@ -1,6 +1,7 @@
 #include "ImageInteractionAnimation.hpp"
 #include "glutils.hpp"
 #include "MultiImageVisualisation.hpp"
+#include "TextureCache.hpp"
 #include <caffe/util/math_functions.hpp>
 
 using namespace fmri;
@@ -10,12 +11,12 @@ void ImageInteractionAnimation::draw(float step)
 {
     auto &vertexBuffer = animate(startingPositions, deltas, step);
 
-    drawImageTiles(vertexBuffer.size() / 3, vertexBuffer.data(), textureCoordinates.data(), texture, getAlpha());
+    texture->draw(vertexBuffer.size() / 3, vertexBuffer.data(), textureCoordinates.data(), getAlpha());
 }
 
 ImageInteractionAnimation::ImageInteractionAnimation(const DType *data, const std::vector<int> &shape, const std::vector<float> &prevPositions,
                                                      const std::vector<float> &curPositions) :
-        texture(data, shape[2], shape[1] * shape[3], GL_LUMINANCE, shape[1]),
+        texture(TextureCache::instance().get(data, shape[2], shape[3], shape[1])),
         startingPositions(MultiImageVisualisation::getVertices(prevPositions)),
         deltas(MultiImageVisualisation::getVertices(curPositions)),
         textureCoordinates(MultiImageVisualisation::getTexCoords(shape[1]))
@@ -31,5 +32,32 @@ void ImageInteractionAnimation::glLoad()
 {
     Drawable::glLoad();
 
-    texture.configure(GL_TEXTURE_2D);
+    texture->configure();
+}
+
+void ImageInteractionAnimation::glUnload()
+{
+    Drawable::glUnload();
+
+    texture->unload();
+}
+
+void ImageInteractionAnimation::glReplace(Drawable &previous)
+{
+    if (auto other = dynamic_cast<ImageInteractionAnimation *>(&previous)) {
+        Drawable::glLoad();
+        texture->configure(*other->texture);
+    } else {
+        Drawable::glReplace(previous);
+    }
+}
+
+std::size_t ImageInteractionAnimation::glMemoryUsage() const
+{
+    return TextureCache::sharedMemoryUsage(texture);
+}
+
+std::size_t ImageInteractionAnimation::vertexBytes() const
+{
+    return Drawable::vertexBytes() + bytesOf(startingPositions) + bytesOf(deltas) + bytesOf(textureCoordinates);
 }
@@ -2,7 +2,8 @@
 
 #include "Animation.hpp"
 #include "utils.hpp"
-#include "Texture.hpp"
+#include <memory>
+#include "VirtualTexture.hpp"
 
 namespace fmri
 {
@@ -13,9 +14,13 @@ namespace fmri
                                           const std::vector<float> &curPositions);
         void draw(float step) override;
         void glLoad() override;
+        void glUnload() override;
+        void glReplace(Drawable& previous) override;
+        std::size_t glMemoryUsage() const override;
+        std::size_t vertexBytes() const override;
 
     private:
-        Texture texture;
+        std::shared_ptr<VirtualTexture> texture;
         std::vector<float> startingPositions;
         std::vector<float> deltas;
         std::vector<float> textureCoordinates;
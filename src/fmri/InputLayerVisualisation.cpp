@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cmath>
 #include <caffe/util/math_functions.hpp>
 #include <GL/glu.h>
 #include <opencv2/core/mat.hpp>
@@ -95,3 +97,49 @@ void InputLayerVisualisation::glLoad()
 
     texture.configure(GL_TEXTURE_2D);
 }
+
+void InputLayerVisualisation::glUnload()
+{
+    Drawable::glUnload();
+
+    texture.unload();
+}
+
+void InputLayerVisualisation::glReplace(Drawable &previous)
+{
+    if (auto other = dynamic_cast<InputLayerVisualisation *>(&previous)) {
+        Drawable::glLoad();
+        texture.configure(GL_TEXTURE_2D, other->texture);
+    } else {
+        Drawable::glReplace(previous);
+    }
+}
+
+std::size_t InputLayerVisualisation::glMemoryUsage() const
+{
+    return texture.memoryUsage();
+}
+
+std::optional<std::array<float, 2>> InputLayerVisualisation::imageCoordinates(const std::array<float, 3> &origin,
+                                                                              const std::array<float, 3> &direction) const
+{
+    // The image lies in the x = 0 plane, see draw().
+    if (std::abs(direction[0]) < EPSILON) {
+        return std::nullopt;
+    }
+
+    const auto distance = -origin[0] / direction[0];
+    const auto y = origin[1] + distance * direction[1];
+    const auto z = origin[2] + distance * direction[2];
+    const std::array<float, 2> coordinates = {-z / targetWidth, 1 - y / targetHeight};
+    if (distance < 0 || coordinates[0] < 0 || coordinates[0] > 1 || coordinates[1] < 0 || coordinates[1] > 1) {
+        return std::nullopt;
+    }
+
+    return coordinates;
+}
+
+float InputLayerVisualisation::nodeRadius() const
+{
+    return std::max(targetWidth, targetHeight) / 2;
+}
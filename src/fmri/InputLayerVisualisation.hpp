@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+#include <optional>
 #include "LayerData.hpp"
 #include "LayerVisualisation.hpp"
 #include "Texture.hpp"
@@ -14,6 +16,20 @@ namespace fmri
         void draw(float time) override;
 
         void glLoad() override;
+        void glUnload() override;
+        void glReplace(Drawable& previous) override;
+        std::size_t glMemoryUsage() const override;
+        float nodeRadius() const override;
+
+        /**
+         * Find where a ray hits the image.
+         *
+         * @param origin Start of the ray, relative to the layer.
+         * @param direction Direction of the ray, need not be normalized.
+         * @return Position on the image, relative to its size with (0, 0) at the top left, if hit.
+         */
+        std::optional<std::array<float, 2>> imageCoordinates(const std::array<float, 3>& origin,
+                                                             const std::array<float, 3>& direction) const;
 
     private:
         float targetWidth;
@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <glog/logging.h>
+#include "InputLoader.hpp"
+#include "FrameScheduler.hpp"
+#include "Tracer.hpp"
+
+using namespace fmri;
+using namespace std;
+
+InputLoader::InputLoader(const Options &options, std::size_t cacheSize) :
+    options(options),
+    cacheSize(cacheSize),
+    stopping(false),
+    results(4),
+    updates(4),
+    dumped(options.inputs().size()),
+    worker(&InputLoader::run, this)
+{
+}
+
+InputLoader::~InputLoader()
+{
+    {
+        lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_one();
+    worker.join();
+}
+
+void InputLoader::schedule(const std::vector<std::size_t> &inputs)
+{
+    {
+        lock_guard<std::mutex> lock(mutex);
+        pending.clear();
+        copy_if(inputs.begin(), inputs.end(), back_inserter(pending), [this](auto input) {
+            return building.count(input) == 0;
+        });
+    }
+    condition.notify_one();
+}
+
+std::optional<InputLoader::Result> InputLoader::poll()
+{
+    auto result = results.pop();
+    if (result) {
+        lock_guard<std::mutex> lock(mutex);
+        building.erase(result->first);
+    }
+
+    return result;
+}
+
+InputLoader::Result InputLoader::wait()
+{
+    std::optional<Result> result;
+    unique_lock<std::mutex> lock(mutex);
+    delivered.wait(lock, [this, &result]() {
+        result = results.pop();
+        return result.has_value();
+    });
+    building.erase(result->first);
+
+    return std::move(*result);
+}
+
+void InputLoader::perturb(Perturbation request)
+{
+    {
+        lock_guard<std::mutex> lock(mutex);
+        perturbation = std::move(request);
+    }
+    condition.notify_one();
+}
+
+std::optional<InputLoader::Update> InputLoader::pollUpdate()
+{
+    return updates.pop();
+}
+
+std::size_t InputLoader::queued() const
+{
+    lock_guard<std::mutex> lock(mutex);
+    return pending.size() + building.size();
+}
+
+void InputLoader::run()
+{
+    Tracer::setThreadName("loader");
+    Simulator simulator(options.model(), options.weights(), options.means());
+    labels = options.labels();
+    dumper = options.imageDumper();
+    exporter = options.tensorExporter();
+
+    while (true) {
+        std::size_t input = 0;
+        std::optional<Perturbation> request;
+        {
+            unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this]() { return stopping || perturbation || !pending.empty(); });
+            if (stopping) {
+                return;
+            }
+
+            if (perturbation) {
+                request.swap(perturbation);
+            } else {
+                input = pending.front();
+                pending.pop_front();
+                building.insert(input);
+            }
+        }
+
+        if (request) {
+            Tracer::setInput(options.inputs().at(request->input));
+            if (!deliver(updates, perturb(simulator, *request))) {
+                return;
+            }
+            continue;
+        }
+
+        Tracer::setInput(options.inputs().at(input));
+        if (!deliver(results, Result(input, build(simulator, input)))) {
+            return;
+        }
+    }
+}
+
+/**
+ * Hand an item to the render thread, and wake it up.
+ *
+ * @return False if the loader was stopped while waiting for room.
+ */
+template<class T>
+bool InputLoader::deliver(SpscQueue<T> &queue, T &&item)
+{
+    // The render thread drains the queues every frame, so they are rarely full.
+    while (!queue.push(std::move(item))) {
+        if (lock_guard<std::mutex> lock(mutex); stopping) {
+            return false;
+        }
+        this_thread::sleep_for(chrono::milliseconds(10));
+    }
+    {
+        // A waiting consumer checks the queue under the lock, so it can't miss this item.
+        lock_guard<std::mutex> lock(mutex);
+    }
+    delivered.notify_one();
+    FrameScheduler::instance().notify();
+
+    return true;
+}
+
+/**
+ * Get the activations for an input, from the cache if possible.
+ */
+InputLoader::Activations InputLoader::activations(Simulator &simulator, std::size_t input)
+{
+    auto cached = find_if(activationCache.begin(), activationCache.end(), [input](const auto &entry) {
+        return entry.first == input;
+    });
+    if (cached != activationCache.end()) {
+        activationCache.splice(activationCache.begin(), activationCache, cached);
+        return cached->second;
+    }
+
+    const auto& path = options.inputs().at(input);
+    Activations result;
+    if (const auto statistic = options.statistic()) {
+        LOG(INFO) << "Loading statistics " << path;
+        Tracer::Span span("load statistics");
+        result.layers = make_shared<const vector<LayerData>>(ActivationStatistics::load(path).layers(*statistic));
+    } else {
+        LOG(INFO) << "Simulating " << path;
+        Tracer::Span span("simulate");
+        if (options.layerStats()) {
+            result.layers = make_shared<const vector<LayerData>>(simulator.simulate(path, result.forwardTimes));
+        } else {
+            result.layers = make_shared<const vector<LayerData>>(simulator.simulate(path));
+        }
+    }
+    const auto& item = result.layers;
+
+    if (!dumped[input]) {
+        if (dumper) {
+            dumper->dump(item, input);
+        }
+        if (exporter) {
+            exporter->write(input, path, item);
+        }
+        dumped[input] = true;
+    }
+
+    if (cacheSize > 0) {
+        activationCache.emplace_front(input, result);
+        if (activationCache.size() > cacheSize) {
+            activationCache.pop_back();
+        }
+    }
+
+    return result;
+}
+
+InputVisualisation InputLoader::build(Simulator &simulator, std::size_t input)
+{
+    Tracer::Span span("build input");
+    const auto simulated = activations(simulator, input);
+    auto dataSet = buildVisualisation(options.inputs().at(input), simulated.layers, simulator.layerInfo(), labels);
+
+    if (options.layerStats()) {
+        annotateCosts(dataSet, simulated.forwardTimes);
+    }
+
+    return dataSet;
+}
+
+/**
+ * Simulate a perturbed input, and rebuild what changed since the last update.
+ */
+InputLoader::Update InputLoader::perturb(Simulator &simulator, const Perturbation &request)
+{
+    Tracer::Span span("perturb input");
+
+    // Forget inputs the render thread has dropped, or rebuilt from scratch.
+    // The base alone can't tell, since the activation cache may hand out the same one again.
+    for (auto it = perturbed.begin(); it != perturbed.end();) {
+        if (it->second.base.expired() || (it->first == request.input && it->second.generation != request.generation)) {
+            it = perturbed.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    auto &latest = perturbed.try_emplace(request.input, PerturbedInput{request.generation, request.base, request.base})
+            .first->second.latest;
+
+    auto layers = make_shared<const vector<LayerData>>(simulator.perturb(options.inputs().at(request.input), request.edits));
+    auto update = updateVisualisation(*latest, layers, *request.positions, simulator.layerInfo(), labels);
+    LOG(INFO) << "Perturbed " << options.inputs().at(request.input) << ", rebuilt " << update.layers.size() << " of "
+              << layers->size() << " layers";
+    latest = std::move(layers);
+
+    return {request.input, std::move(update)};
+}
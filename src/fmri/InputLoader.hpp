@@ -0,0 +1,169 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "Options.hpp"
+#include "Simulator.hpp"
+#include "SpscQueue.hpp"
+#include "visualisations.hpp"
+
+namespace fmri
+{
+    /**
+     * Background thread that simulates and visualises inputs on request.
+     *
+     * Inputs are built in the order of the last schedule() call, so the
+     * caller controls priorities by rescheduling. Finished inputs are
+     * handed back through a lock-free queue.
+     *
+     * Recently simulated activations are cached, so an input that is
+     * requested again only needs its visualisations rebuilt.
+     *
+     * Inputs can also be perturbed, by painting over them. Perturbations
+     * take priority over building inputs, and only the latest request is
+     * kept, so the loader never falls behind on edits.
+     */
+    class InputLoader
+    {
+    public:
+        typedef std::pair<std::size_t, InputVisualisation> Result;
+        typedef std::pair<std::size_t, VisualisationUpdate> Update;
+
+        /**
+         * Simulation results for a single input.
+         */
+        struct Activations
+        {
+            std::shared_ptr<const std::vector<LayerData>> layers;
+            // Forward time of every layer, empty unless layer statistics are enabled.
+            std::vector<std::chrono::steady_clock::duration> forwardTimes;
+        };
+
+        /**
+         * Request to simulate an input with edits painted over it.
+         */
+        struct Perturbation
+        {
+            std::size_t input;
+            // Edit session, changes whenever the input is rebuilt from scratch.
+            std::size_t generation;
+            // Activations the input was built from, before any edits.
+            std::shared_ptr<const std::vector<LayerData>> base;
+            // Node positions of every layer of the input.
+            std::shared_ptr<const std::vector<std::vector<float>>> positions;
+            // All edits to the input so far.
+            std::vector<Simulator::Brush> edits;
+        };
+
+        /**
+         * Start loading.
+         *
+         * @param options Options to simulate with. Copied for the loader thread.
+         * @param cacheSize Number of inputs to cache activations for.
+         */
+        InputLoader(const Options& options, std::size_t cacheSize);
+        ~InputLoader();
+
+        /**
+         * Replace the pending requests.
+         *
+         * Inputs that are already being built or waiting to be collected
+         * are skipped.
+         *
+         * @param inputs Indices of the inputs to build, most urgent first.
+         */
+        void schedule(const std::vector<std::size_t>& inputs);
+
+        /**
+         * Collect a finished input. Only call this from a single thread.
+         *
+         * @return The index and visualisation of the input, if one was finished.
+         */
+        std::optional<Result> poll();
+
+        /**
+         * Block until an input is finished, and collect it. Only call this from a single thread.
+         *
+         * At least one input should be scheduled or waiting to be collected.
+         *
+         * @return The index and visualisation of the input.
+         */
+        Result wait();
+
+        /**
+         * Replace the pending perturbation, if any.
+         *
+         * Updates for an input are relative to the previous update for the
+         * same base, so all of them should be applied in order.
+         *
+         * @param request
+         */
+        void perturb(Perturbation request);
+
+        /**
+         * Collect the update of a perturbed input. Only call this from a single thread.
+         *
+         * @return The index of the input and its changed visualisations, if a perturbation was finished.
+         */
+        std::optional<Update> pollUpdate();
+
+        /**
+         * @return Number of inputs requested but not yet collected.
+         */
+        std::size_t queued() const;
+
+    private:
+        const Options options;
+        const std::size_t cacheSize;
+
+        mutable std::mutex mutex;
+        std::condition_variable condition;
+        // Signalled whenever the loader hands over an item.
+        std::condition_variable delivered;
+        std::deque<std::size_t> pending;
+        // Inputs taken from pending that have not been collected yet.
+        std::set<std::size_t> building;
+        std::optional<Perturbation> perturbation;
+        bool stopping;
+
+        SpscQueue<Result> results;
+        SpscQueue<Update> updates;
+
+        // Owned by the loader thread.
+        std::optional<std::vector<std::string>> labels;
+        std::optional<PNGDumper> dumper;
+        std::optional<NpyExporter> exporter;
+        std::list<std::pair<std::size_t, Activations>> activationCache;
+        std::vector<bool> dumped;
+        /**
+         * Activations of the last update of a perturbed input.
+         */
+        struct PerturbedInput
+        {
+            std::size_t generation;
+            std::weak_ptr<const std::vector<LayerData>> base;
+            std::shared_ptr<const std::vector<LayerData>> latest;
+        };
+        std::map<std::size_t, PerturbedInput> perturbed;
+
+        std::thread worker;
+
+        void run();
+        InputVisualisation build(Simulator& simulator, std::size_t input);
+        Activations activations(Simulator& simulator, std::size_t input);
+        Update perturb(Simulator& simulator, const Perturbation& request);
+
+        template<class T>
+        bool deliver(SpscQueue<T>& queue, T&& item);
+    };
+}
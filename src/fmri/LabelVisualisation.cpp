@@ -1,19 +1,29 @@
 #include <GL/gl.h>
+#include "Colormap.hpp"
+#include "DrawList.hpp"
 #include "LabelVisualisation.hpp"
 #include "glutils.hpp"
 #include "RenderingState.hpp"
+#include "FrameProfiler.hpp"
 
 using namespace fmri;
 
 void LabelVisualisation::draw(float)
 {
+    const auto &colormap = Colormap::instance();
+    const auto alpha = getAlpha();
+
     glPushMatrix();
     glTranslatef(LAYER_X_OFFSET, 0, 0);
 
     for (auto i = 0u; i < nodeLabels.size(); ++i) {
         glPushMatrix();
         glTranslatef(nodePositions_[3 * i], nodePositions_[3 * i + 1], nodePositions_[3 * i + 2]);
-        setGlColor(colorBuffer[i]);
+        auto color = colormap.color(saturations[i]);
+        if constexpr (alphaEnabled()) {
+            color[3] = alpha;
+        }
+        setGlColor(color);
         renderText(nodeLabels[i]);
         glPopMatrix();
     }
@@ -38,26 +48,25 @@ LabelVisualisation::LabelVisualisation(const std::vector<float> &positions, cons
         char nameBuffer[50];
         std::snprintf(nameBuffer, sizeof(nameBuffer), "%.2f - %s", prevData[i], labels[i].c_str());
 
-        colorBuffer.emplace_back(interpolate(prevData[i] / maxVal, POSITIVE_COLOR, NEUTRAL_COLOR));
+        saturations.push_back(prevData[i] / maxVal);
         std::copy_n(positions.begin() + 3 * i, 3, nodeInserter);
         nodeLabels.emplace_back(nameBuffer);
     }
 
     // Now fix the points for the interaction paths.
-    nodeIndices.reserve(2 * nodeLabels.size());
+    std::vector<unsigned int> indices;
+    indices.reserve(2 * nodeLabels.size());
     for (auto i = 0u; i < nodeLabels.size(); ++i) {
-        nodeIndices.push_back(i);
-        nodeIndices.push_back(i + nodeLabels.size());
+        indices.push_back(i);
+        indices.push_back(i + nodeLabels.size());
     }
+    nodeIndices = IndexBuffer(indices);
 
     // Make sure the end positions exist.
     std::copy_n(nodePositions_.begin(), nodePositions_.size(), nodeInserter);
     for (auto i = nodePositions_.size() / 2; i < nodePositions_.size(); i += 3) {
         nodePositions_[i] = LAYER_X_OFFSET;
     }
-
-
-    patchTransparency();
 }
 
 void LabelVisualisation::drawPaths()
@@ -65,6 +74,23 @@ void LabelVisualisation::drawPaths()
     setGlColor(RenderingState::instance().pathColor());
     glEnableClientState(GL_VERTEX_ARRAY);
     glVertexPointer(3, GL_FLOAT, 0, nodePositions_.data());
-    glDrawElements(GL_LINES, nodeIndices.size(), GL_UNSIGNED_INT, nodeIndices.data());
+    nodeIndices.draw(GL_LINES);
+    FrameProfiler::instance().countDraw(nodeIndices.size());
     glDisableClientState(GL_VERTEX_ARRAY);
 }
+
+std::size_t LabelVisualisation::vertexBytes() const
+{
+    return Drawable::vertexBytes() + bytesOf(nodePositions_) + bytesOf(saturations);
+}
+
+std::size_t LabelVisualisation::indexBytes() const
+{
+    return nodeIndices.bytes();
+}
+
+bool LabelVisualisation::compilePaths(DrawList &list) const
+{
+    list.addPaths(nodePositions_, nodeIndices);
+    return true;
+}
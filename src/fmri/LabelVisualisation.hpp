@@ -2,6 +2,7 @@
 
 #include "LayerData.hpp"
 #include "Animation.hpp"
+#include "VertexBuffers.hpp"
 
 namespace fmri
 {
@@ -11,12 +12,17 @@ namespace fmri
         LabelVisualisation(const std::vector<float>& positions, const LayerData& prevData, const std::vector<std::string>& labels);
         void draw(float time) override;
         void drawPaths() override;
+        std::size_t vertexBytes() const override;
+        std::size_t indexBytes() const override;
+        bool compilePaths(DrawList& list) const override;
 
     private:
         static constexpr float DISPLAY_LIMIT = 0.01;
 
         std::vector<std::string> nodeLabels;
+        // Position in the colormap of every label.
+        std::vector<float> saturations;
         std::vector<float> nodePositions_;
-        std::vector<int> nodeIndices;
+        IndexBuffer nodeIndices;
     };
 }
@@ -10,6 +10,11 @@ const std::vector<float> &fmri::LayerVisualisation::nodePositions() const
     return nodePositions_;
 }
 
+float fmri::LayerVisualisation::nodeRadius() const
+{
+    return 1;
+}
+
 fmri::LayerVisualisation::LayerVisualisation(size_t numNodes)
         : nodePositions_(numNodes * 3)
 {
@@ -35,15 +40,38 @@ float fmri::LayerVisualisation::getAlpha()
 
 void fmri::LayerVisualisation::setupLayerName(std::string_view name, fmri::LayerInfo::Type type)
 {
-    displayName = name;
-    displayName += ": ";
-    displayName += LayerInfo::nameByType(type);
+    displayName_ = name;
+    displayName_ += ": ";
+    displayName_ += LayerInfo::nameByType(type);
+}
+
+void fmri::LayerVisualisation::setAnnotation(std::string_view annotation, float heat)
+{
+    this->annotation = annotation;
+    // Fade from the colour of the layer name to red for the heaviest layers.
+    annotationColor = {0.5f + 0.5f * heat, 0.5f - 0.3f * heat, 0.5f - 0.3f * heat, 1};
+}
+
+void fmri::LayerVisualisation::copyAnnotation(const fmri::LayerVisualisation &other)
+{
+    annotation = other.annotation;
+    annotationColor = other.annotationColor;
+}
+
+const std::string &fmri::LayerVisualisation::displayName() const
+{
+    return displayName_;
 }
 
 void fmri::LayerVisualisation::drawLayerName() const
 {
     glColor3f(0.5, 0.5, 0.5);
-    renderText(displayName);
+    renderText(displayName_);
+
+    if (!annotation.empty()) {
+        setGlColor(annotationColor);
+        renderTextBelow(annotation, 1);
+    }
 
     glTranslatef(0, 0, -10);
 }
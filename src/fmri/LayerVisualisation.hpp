@@ -21,12 +21,30 @@ namespace fmri
         virtual ~LayerVisualisation() = default;
 
         virtual const std::vector<float>& nodePositions() const;
+        /**
+         * @return Radius around a node position that belongs to that node, used for picking.
+         */
+        virtual float nodeRadius() const;
         void drawLayerName() const;
+        const std::string& displayName() const;
         void setupLayerName(std::string_view name, LayerInfo::Type type);
+        /**
+         * Show extra information below the layer name.
+         *
+         * @param annotation Text to show.
+         * @param heat How heavy the layer is compared to the rest of the network, 0..1.
+         */
+        void setAnnotation(std::string_view annotation, float heat);
+        /**
+         * Show the same annotation as another layer, like the one this replaces.
+         */
+        void copyAnnotation(const LayerVisualisation& other);
 
     protected:
         std::vector<float> nodePositions_;
-        std::string displayName;
+        std::string displayName_;
+        std::string annotation;
+        Color annotationColor;
 
         template<Ordering Order>
         void initNodePositions(size_t n, float spacing);
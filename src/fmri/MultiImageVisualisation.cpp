@@ -1,13 +1,15 @@
+#include <cmath>
 #include <glog/logging.h>
 #include "MultiImageVisualisation.hpp"
 #include "glutils.hpp"
 #include "Range.hpp"
+#include "TextureCache.hpp"
 
 using namespace fmri;
 using namespace std;
 
 MultiImageVisualisation::MultiImageVisualisation(const fmri::LayerData &layer) :
-    texture(layer.data(), layer.shape().at(2), layer.shape().at(3) * layer.shape().at(1), GL_LUMINANCE, layer.shape().at(1))
+    texture(TextureCache::instance().get(layer.data(), layer.shape().at(2), layer.shape().at(3), layer.shape().at(1)))
 {
     auto dimensions = layer.shape();
 
@@ -26,7 +28,7 @@ MultiImageVisualisation::MultiImageVisualisation(const fmri::LayerData &layer) :
 
 void MultiImageVisualisation::draw(float)
 {
-    drawImageTiles(vertexBuffer.size() / 3, vertexBuffer.data(), texCoordBuffer.data(), texture, getAlpha());
+    texture->draw(vertexBuffer.size() / 3, vertexBuffer.data(), texCoordBuffer.data(), getAlpha());
 }
 
 vector<float> MultiImageVisualisation::getVertices(const std::vector<float> &nodePositions, float scaling)
@@ -46,16 +48,15 @@ vector<float> MultiImageVisualisation::getVertices(const std::vector<float> &nod
 std::vector<float> MultiImageVisualisation::getTexCoords(int n)
 {
     std::vector<float> coords;
-    coords.reserve(8 * n);
-
-    const float channels = n;
+    coords.reserve(12 * n);
 
     for (int i = 0; i < n; ++i) {
-        std::array<float, 8> textureCoords = {
-                1, (i + 1) / channels,
-                1, i / channels,
-                0, i / channels,
-                0, (i + 1) / channels,
+        const float layer = i;
+        std::array<float, 12> textureCoords = {
+                1, 1, layer,
+                1, 0, layer,
+                0, 0, layer,
+                0, 1, layer,
         };
 
         for (auto coord : textureCoords) {
@@ -70,5 +71,38 @@ void MultiImageVisualisation::glLoad()
 {
     Drawable::glLoad();
 
-    texture.configure(GL_TEXTURE_2D);
+    texture->configure();
+}
+
+void MultiImageVisualisation::glUnload()
+{
+    Drawable::glUnload();
+
+    texture->unload();
+}
+
+void MultiImageVisualisation::glReplace(Drawable &previous)
+{
+    if (auto other = dynamic_cast<MultiImageVisualisation *>(&previous)) {
+        Drawable::glLoad();
+        texture->configure(*other->texture);
+    } else {
+        Drawable::glReplace(previous);
+    }
+}
+
+std::size_t MultiImageVisualisation::glMemoryUsage() const
+{
+    return TextureCache::sharedMemoryUsage(texture);
+}
+
+std::size_t MultiImageVisualisation::vertexBytes() const
+{
+    return Drawable::vertexBytes() + bytesOf(vertexBuffer) + bytesOf(texCoordBuffer);
+}
+
+float MultiImageVisualisation::nodeRadius() const
+{
+    // Tiles extend one unit in every direction from their centre.
+    return std::sqrt(2.f);
 }
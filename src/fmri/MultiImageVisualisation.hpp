@@ -4,7 +4,7 @@
 #include <memory>
 #include "LayerVisualisation.hpp"
 #include "LayerData.hpp"
-#include "Texture.hpp"
+#include "VirtualTexture.hpp"
 
 namespace fmri
 {
@@ -23,12 +23,23 @@ namespace fmri
         void draw(float time) override;
 
         void glLoad() override;
+        void glUnload() override;
+        void glReplace(Drawable& previous) override;
+        std::size_t glMemoryUsage() const override;
+        std::size_t vertexBytes() const override;
+        float nodeRadius() const override;
 
         static vector<float> getVertices(const std::vector<float> &nodePositions, float scaling = 1);
+        /**
+         * Texture coordinates for n tiles of a texture array.
+         *
+         * @param n Number of tiles.
+         * @return Three components (s, t, layer) per vertex.
+         */
         static std::vector<float> getTexCoords(int n);
 
     private:
-        Texture texture;
+        std::shared_ptr<VirtualTexture> texture;
         std::vector<float> vertexBuffer;
         std::vector<float> texCoordBuffer;
     };
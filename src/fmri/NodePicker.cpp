@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <glog/logging.h>
+#include "NodePicker.hpp"
+#include "Range.hpp"
+
+using namespace fmri;
+
+NodePicker::NodePicker(const InputVisualisation &input, const std::vector<Vector> &layerOrigins)
+{
+    CHECK_EQ(input.layers.size(), layerOrigins.size()) << "Every layer needs an origin.";
+
+    for (auto layer : Range(input.layers.size())) {
+        const auto &visualisation = *input.layers[layer].first;
+        const auto &positions = visualisation.nodePositions();
+        const auto &origin = layerOrigins[layer];
+        const auto radius = visualisation.nodeRadius();
+
+        for (auto i = 0u; i < positions.size(); i += 3) {
+            items.push_back({
+                {origin[0] + positions[i], origin[1] + positions[i + 1], origin[2] + positions[i + 2]},
+                radius,
+                static_cast<std::uint32_t>(layer),
+                i / 3
+            });
+        }
+    }
+
+    if (!items.empty()) {
+        nodes.reserve(2 * items.size() / LEAF_SIZE + 1);
+        build(0, items.size());
+    }
+}
+
+void NodePicker::build(std::uint32_t start, std::uint32_t end)
+{
+    constexpr auto inf = std::numeric_limits<float>::infinity();
+    Node node = {{inf, inf, inf}, {-inf, -inf, -inf}, start, end - start};
+    for (auto i : Range(start, end)) {
+        for (auto axis : Range(3)) {
+            node.min[axis] = std::min(node.min[axis], items[i].center[axis] - items[i].radius);
+            node.max[axis] = std::max(node.max[axis], items[i].center[axis] + items[i].radius);
+        }
+    }
+
+    const auto index = nodes.size();
+    nodes.push_back(node);
+
+    if (end - start <= LEAF_SIZE) {
+        return;
+    }
+
+    // Split on the median of the longest axis.
+    const auto extent = [&node](int axis) { return node.max[axis] - node.min[axis]; };
+    int axis = 0;
+    for (auto i : Range(1, 3)) {
+        if (extent(i) > extent(axis)) {
+            axis = i;
+        }
+    }
+
+    const auto middle = start + (end - start) / 2;
+    std::nth_element(items.begin() + start, items.begin() + middle, items.begin() + end,
+                     [axis](const Item &a, const Item &b) { return a.center[axis] < b.center[axis]; });
+
+    build(start, middle);
+    nodes[index].offset = nodes.size();
+    nodes[index].count = 0;
+    build(middle, end);
+}
+
+/**
+ * Slab test of a ray against a bounding box.
+ *
+ * @return The distance to the box along the ray, or infinity on a miss.
+ */
+static float intersectBox(const NodePicker::Vector &origin, const NodePicker::Vector &inverseDirection,
+                          const NodePicker::Vector &min, const NodePicker::Vector &max)
+{
+    float near = 0, far = std::numeric_limits<float>::infinity();
+    for (auto axis : Range(3)) {
+        auto t1 = (min[axis] - origin[axis]) * inverseDirection[axis];
+        auto t2 = (max[axis] - origin[axis]) * inverseDirection[axis];
+        if (t1 > t2) {
+            std::swap(t1, t2);
+        }
+        near = std::max(near, t1);
+        far = std::min(far, t2);
+    }
+
+    return near <= far ? near : std::numeric_limits<float>::infinity();
+}
+
+/**
+ * @return Distance to the sphere along a normalized ray, or infinity on a miss.
+ */
+static float intersectSphere(const NodePicker::Vector &origin, const NodePicker::Vector &direction,
+                             const NodePicker::Vector &center, float radius)
+{
+    NodePicker::Vector offset;
+    for (auto axis : Range(3)) {
+        offset[axis] = center[axis] - origin[axis];
+    }
+
+    const auto projection = offset[0] * direction[0] + offset[1] * direction[1] + offset[2] * direction[2];
+    // Measure the perpendicular offset directly, subtracting squares loses too much precision far away.
+    float distanceSquared = 0;
+    for (auto axis : Range(3)) {
+        const auto perpendicular = offset[axis] - projection * direction[axis];
+        distanceSquared += perpendicular * perpendicular;
+    }
+    const auto radiusSquared = radius * radius;
+    if (distanceSquared > radiusSquared) {
+        return std::numeric_limits<float>::infinity();
+    }
+
+    const auto t = projection - std::sqrt(radiusSquared - distanceSquared);
+    return t >= 0 ? t : std::numeric_limits<float>::infinity();
+}
+
+std::optional<NodePicker::Hit> NodePicker::pick(const Vector &origin, const Vector &direction) const
+{
+    if (nodes.empty()) {
+        return std::nullopt;
+    }
+
+    const auto length = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+    Vector normalized, inverse;
+    for (auto axis : Range(3)) {
+        normalized[axis] = direction[axis] / length;
+        inverse[axis] = 1 / normalized[axis];
+    }
+
+    std::optional<Hit> best;
+    auto bestDistance = std::numeric_limits<float>::infinity();
+
+    std::vector<std::uint32_t> stack = {0};
+    while (!stack.empty()) {
+        const auto &node = nodes[stack.back()];
+        const auto current = stack.back();
+        stack.pop_back();
+
+        if (intersectBox(origin, inverse, node.min, node.max) >= bestDistance) {
+            continue;
+        }
+
+        if (node.count > 0) {
+            for (auto i : Range(node.offset, node.offset + node.count)) {
+                const auto &item = items[i];
+                const auto t = intersectSphere(origin, normalized, item.center, item.radius);
+                if (t < bestDistance) {
+                    bestDistance = t;
+                    best = Hit{item.layer, item.node, t};
+                }
+            }
+        } else {
+            stack.push_back(node.offset);
+            stack.push_back(current + 1);
+        }
+    }
+
+    return best;
+}
+
+std::size_t NodePicker::size() const
+{
+    return items.size();
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "visualisations.hpp"
+
+namespace fmri
+{
+    /**
+     * Bounding volume hierarchy over the nodes of a single input.
+     *
+     * Every node is treated as a sphere around its position, with the
+     * radius given by its layer visualisation. Building is O(n log n),
+     * after which a ray can be resolved to a node in O(log n).
+     */
+    class NodePicker
+    {
+    public:
+        typedef std::array<float, 3> Vector;
+
+        struct Hit
+        {
+            std::size_t layer;
+            std::size_t node;
+            float distance;
+        };
+
+        /**
+         * Build a picker for the given input.
+         *
+         * @param input Visualisations to pick nodes from.
+         * @param layerOrigins World position of every layer's node coordinates.
+         */
+        NodePicker(const InputVisualisation &input, const std::vector<Vector> &layerOrigins);
+
+        /**
+         * Find the nearest node along a ray.
+         *
+         * @param origin Start of the ray.
+         * @param direction Direction of the ray, need not be normalized.
+         * @return The first node hit, if any.
+         */
+        std::optional<Hit> pick(const Vector &origin, const Vector &direction) const;
+
+        std::size_t size() const;
+
+    private:
+        static constexpr std::uint32_t LEAF_SIZE = 8;
+
+        struct Item
+        {
+            Vector center;
+            float radius;
+            std::uint32_t layer;
+            std::uint32_t node;
+        };
+
+        struct Node
+        {
+            Vector min;
+            Vector max;
+            /** Leaves: first item. Interior nodes: index of the second child, the first follows directly. */
+            std::uint32_t offset;
+            /** Number of items, 0 for interior nodes. */
+            std::uint32_t count;
+        };
+
+        std::vector<Item> items;
+        std::vector<Node> nodes;
+
+        void build(std::uint32_t start, std::uint32_t end);
+    };
+}
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include <glog/logging.h>
+
+#include "NpyExporter.hpp"
+#include "Tracer.hpp"
+#include "utils.hpp"
+
+using namespace fmri;
+
+// The .npy format stores the byte order in the header, so use the native one.
+static constexpr char NATIVE_BYTE_ORDER = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ ? '<' : '>';
+// Version 1.0 headers are padded so the data is aligned to this many bytes.
+static constexpr std::size_t HEADER_ALIGNMENT = 64;
+
+/**
+ * Replace characters that are not allowed in file names.
+ */
+static std::string fileName(std::string_view name)
+{
+    std::string result(name);
+    std::replace(result.begin(), result.end(), '/', '_');
+    return result;
+}
+
+/**
+ * Get the file name of a path without directories or extension.
+ */
+static std::string_view stem(std::string_view path)
+{
+    if (auto slash = path.rfind('/'); slash != std::string_view::npos) {
+        path.remove_prefix(slash + 1);
+    }
+    if (auto dot = path.rfind('.'); dot != std::string_view::npos && dot > 0) {
+        path = path.substr(0, dot);
+    }
+
+    return path;
+}
+
+/**
+ * Build a version 1.0 .npy header for a float array.
+ */
+static std::string npyHeader(const std::vector<int> &shape)
+{
+    std::ostringstream dict;
+    dict << "{'descr': '" << NATIVE_BYTE_ORDER << 'f' << sizeof(DType) << "', 'fortran_order': False, 'shape': (";
+    for (auto i = 0u; i < shape.size(); ++i) {
+        dict << (i ? ", " : "") << shape[i];
+    }
+    dict << (shape.size() == 1 ? ",), }" : "), }");
+
+    auto dictionary = dict.str();
+    // Magic string, version, header length, dictionary and terminating newline.
+    const auto length = 6 + 2 + 2 + dictionary.size() + 1;
+    dictionary.append((HEADER_ALIGNMENT - length % HEADER_ALIGNMENT) % HEADER_ALIGNMENT, ' ');
+    dictionary += '\n';
+
+    std::string header("\x93NUMPY\x01\x00", 8);
+    header += static_cast<char>(dictionary.size() & 0xff);
+    header += static_cast<char>(dictionary.size() >> 8);
+    header += dictionary;
+
+    return header;
+}
+
+NpyExporter::NpyExporter(std::string_view baseDir) :
+        baseDir_(baseDir),
+        queue(std::make_unique<WorkQueue>(1))
+{
+    ensureDirectory(baseDir_);
+}
+
+void NpyExporter::write(std::size_t index, std::string_view input, std::shared_ptr<const std::vector<LayerData>> layers)
+{
+    auto dir = baseDir_ + "/" + std::to_string(index) + "-" + fileName(stem(input));
+    queue->submit([this, dir, layers]() {
+        Tracer::Span span("export");
+        ensureDirectory(dir);
+        for (auto &layer : *layers) {
+            writeLayer(dir, layer);
+        }
+    });
+}
+
+void NpyExporter::wait()
+{
+    queue->wait();
+}
+
+void NpyExporter::writeLayer(const std::string &dir, const LayerData &layer) const
+{
+    const auto path = dir + "/" + fileName(layer.name()) + ".npy";
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        LOG(ERROR) << "Failed to open " << path;
+        return;
+    }
+
+    const auto header = npyHeader(layer.shape());
+    out.write(header.data(), header.size());
+    // A single write for the whole layer, so the stream can bypass its buffer.
+    out.write(reinterpret_cast<const char *>(layer.data()), layer.numEntries() * sizeof(DType));
+
+    if (!out) {
+        LOG(ERROR) << "Failed to write " << path;
+    }
+}
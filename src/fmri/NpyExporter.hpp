@@ -0,0 +1,51 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "LayerData.hpp"
+#include "WorkQueue.hpp"
+
+namespace fmri
+{
+    /**
+     * Writes the raw activations of every layer to NumPy .npy files.
+     *
+     * Each input gets its own directory, named <index>-<stem> so inputs
+     * with the same file name stay apart. It contains a file per layer
+     * that numpy.load can memory-map. Files are written in the
+     * background by a single thread, so writes stay sequential.
+     */
+    class NpyExporter
+    {
+    public:
+        /**
+         * @param baseDir Directory to write to, created if needed.
+         */
+        explicit NpyExporter(std::string_view baseDir);
+
+        /**
+         * Queue the layers of an input for writing.
+         *
+         * The layers are kept alive until they have been written.
+         *
+         * @param index Index of the input, used to name its directory.
+         * @param input Path of the input, used to name its directory.
+         * @param layers
+         */
+        void write(std::size_t index, std::string_view input, std::shared_ptr<const std::vector<LayerData>> layers);
+
+        /**
+         * Wait until everything queued has been written.
+         */
+        void wait();
+
+    private:
+        std::string baseDir_;
+        std::unique_ptr<WorkQueue> queue;
+
+        void writeLayer(const std::string& dir, const LayerData& layer) const;
+    };
+}
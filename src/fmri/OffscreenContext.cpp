@@ -0,0 +1,147 @@
+#include <cstring>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <glog/logging.h>
+#include "OffscreenContext.hpp"
+
+using namespace fmri;
+
+/**
+ * Get an EGL display that does not need a window system.
+ *
+ * Prefers Mesa's surfaceless platform, and falls back to the default display.
+ */
+static EGLDisplay getDisplay()
+{
+    const char *extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (extensions != nullptr && std::strstr(extensions, "EGL_MESA_platform_surfaceless") != nullptr) {
+        auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+                eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (getPlatformDisplay != nullptr) {
+            auto display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            if (display != EGL_NO_DISPLAY) {
+                return display;
+            }
+        }
+    }
+
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+OffscreenContext::OffscreenContext(int width, int height) :
+        width_(width),
+        height_(height),
+        display(EGL_NO_DISPLAY),
+        surface(EGL_NO_SURFACE),
+        context(EGL_NO_CONTEXT),
+        framebuffer(0),
+        colorBuffer(0),
+        depthBuffer(0)
+{
+    CHECK_GT(width, 0) << "Invalid framebuffer width";
+    CHECK_GT(height, 0) << "Invalid framebuffer height";
+
+    createContext();
+    createFramebuffer();
+
+    glViewport(0, 0, width, height);
+    LOG(INFO) << "Offscreen rendering with " << glGetString(GL_RENDERER) << ", OpenGL " << glGetString(GL_VERSION);
+}
+
+OffscreenContext::~OffscreenContext()
+{
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(1, &colorBuffer);
+    glDeleteRenderbuffers(1, &depthBuffer);
+
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(display, context);
+    if (surface != EGL_NO_SURFACE) {
+        eglDestroySurface(display, surface);
+    }
+    eglTerminate(display);
+}
+
+void OffscreenContext::createContext()
+{
+    display = getDisplay();
+    CHECK(display != EGL_NO_DISPLAY) << "No EGL display available";
+    CHECK(eglInitialize(display, nullptr, nullptr)) << "Failed to initialize EGL: " << eglGetError();
+
+    const EGLint configAttributes[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_RED_SIZE, 8,
+            EGL_GREEN_SIZE, 8,
+            EGL_BLUE_SIZE, 8,
+            EGL_ALPHA_SIZE, 8,
+            EGL_DEPTH_SIZE, 24,
+            EGL_NONE
+    };
+    EGLConfig config;
+    EGLint numConfigs = 0;
+    const bool hasConfig = eglChooseConfig(display, configAttributes, &config, 1, &numConfigs) && numConfigs > 0;
+
+    CHECK(eglBindAPI(EGL_OPENGL_API)) << "Desktop OpenGL unavailable through EGL";
+
+    if (hasConfig) {
+        // A tiny surface just to make the context current, rendering goes to the framebuffer object.
+        const EGLint surfaceAttributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+        surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, nullptr);
+    } else {
+        // Surfaceless platforms may not offer pbuffer configs, but can do without a surface.
+        context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, nullptr);
+    }
+
+    CHECK(context != EGL_NO_CONTEXT) << "Failed to create OpenGL context: " << eglGetError();
+    CHECK(eglMakeCurrent(display, surface, surface, context)) << "Failed to activate OpenGL context: " << eglGetError();
+}
+
+void OffscreenContext::createFramebuffer()
+{
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+    glGenRenderbuffers(1, &colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width_, height_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width_, height_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+
+    CHECK_EQ(glCheckFramebufferStatus(GL_FRAMEBUFFER), GL_FRAMEBUFFER_COMPLETE) << "Incomplete framebuffer";
+
+    glDrawBuffer(GL_COLOR_ATTACHMENT0);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+}
+
+std::vector<unsigned char> OffscreenContext::readPixels() const
+{
+    std::vector<unsigned char> pixels(3 * width_ * height_);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width_, height_, GL_BGR, GL_UNSIGNED_BYTE, pixels.data());
+
+    // OpenGL stores the bottom row first.
+    const auto stride = 3 * width_;
+    for (int row = 0; row < height_ / 2; ++row) {
+        std::swap_ranges(pixels.begin() + row * stride, pixels.begin() + (row + 1) * stride,
+                         pixels.begin() + (height_ - row - 1) * stride);
+    }
+
+    return pixels;
+}
+
+int OffscreenContext::width() const
+{
+    return width_;
+}
+
+int OffscreenContext::height() const
+{
+    return height_;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+#include <EGL/egl.h>
+#include <GL/gl.h>
+
+namespace fmri
+{
+    /**
+     * Window-less OpenGL context for rendering to images.
+     *
+     * Creates an OpenGL context through EGL, which works without a
+     * display server (for instance with Mesa's software rasteriser),
+     * and renders into a framebuffer object of a fixed size.
+     *
+     * Constructing this object makes its context current.
+     */
+    class OffscreenContext
+    {
+    public:
+        OffscreenContext(int width, int height);
+        OffscreenContext(const OffscreenContext&) = delete;
+        ~OffscreenContext();
+
+        OffscreenContext& operator=(const OffscreenContext&) = delete;
+
+        /**
+         * Read back the current contents of the framebuffer.
+         *
+         * @return Tightly packed BGR pixels, top row first.
+         */
+        std::vector<unsigned char> readPixels() const;
+
+        int width() const;
+        int height() const;
+
+    private:
+        int width_;
+        int height_;
+        EGLDisplay display;
+        EGLSurface surface;
+        EGLContext context;
+        GLuint framebuffer;
+        GLuint colorBuffer;
+        GLuint depthBuffer;
+
+        void createContext();
+        void createFramebuffer();
+    };
+}
@@ -2,7 +2,7 @@
 #include <iostream>
 #include <boost/program_options.hpp>
 #include <fstream>
-#include <GL/gl.h>
+#include <sstream>
 #include "Options.hpp"
 #include "visualisations.hpp"
 #include "../common/config_files.hpp"
@@ -77,6 +77,29 @@ static inline void parse_color(const std::string& input, Color& targetColor)
     parse_color(input.c_str(), targetColor);
 }
 
+/**
+ * Parse a list of numbers separated by a single character.
+ *
+ * @tparam N Number of values to parse.
+ * @param input
+ * @param separator
+ * @param target
+ */
+template<class T, std::size_t N>
+static void parse_list(const std::string& input, char separator, std::array<T, N>& target)
+{
+    std::istringstream stream(input);
+    for (auto i = 0u; i < N; ++i) {
+        char sep = separator;
+        if ((i > 0 && !(stream >> sep)) || sep != separator || !(stream >> target[i])) {
+            char errorBuf[1024];
+            std::snprintf(errorBuf, sizeof(errorBuf), "Expected %zu values separated by '%c', got: %s", N, separator,
+                          input.c_str());
+            throw std::invalid_argument(errorBuf);
+        }
+    }
+}
+
 static void use_color(const boost::program_options::variables_map& vm, const char* key, Color& target) {
     if (vm.count(key)) {
         parse_color(vm[key].as<std::string>(), target);
@@ -86,9 +109,28 @@ static void use_color(const boost::program_options::variables_map& vm, const cha
 Options::Options(int argc, char * const argv[]):
         layerTransparency_(1),
         interactionTransparency_(1),
+        activationThreshold_(0),
         pathColor_({1, 1, 1, 0.1}),
+        dumpFormat("png"),
+        dumpCompression(3),
+        dumpThreads(0),
+        dumpMosaic(false),
         brainMode_(false),
-        inputMillis_(1000)
+        layerStats_(false),
+        inputMillis_(1000),
+        vramBudget_(1024),
+        textureBudget_(256),
+        idleTimeout_(60),
+        backgroundColor_({0, 0, 0, 0}),
+        inputWindow_(0),
+        activationCache_(32),
+        cameraPosition_({0, 0, 3}),
+        cameraAngle_({0, 0}),
+        animationTime_(0),
+        frameSize_({1280, 720}),
+        encodeThreads_(0),
+        perfTolerance_(0.1),
+        perfRuns_(3)
 {
     using namespace boost::program_options;
 
@@ -125,6 +167,7 @@ Options::Options(int argc, char * const argv[]):
                 ("path-color,p", value<std::string>()->default_value("#ffffff19"), "color for paths")
                 ("layer-opacity", value_for(layerTransparency_), "Opacity for layers")
                 ("interaction-opacity", value_for(interactionTransparency_), "Opacity for interactions")
+                ("activation-threshold", value_for(activationThreshold_), "Fraction of the largest activation in a layer that nodes need to count as activated, 0-1")
                 ("layer-distance", value_for(LAYER_X_OFFSET), "Distance between layers")
                 ("interaction-limit", value_for(INTERACTION_LIMIT), "Maximum number of interactions per layer")
                 ("neutral-color", value<std::string>(), "Color for showing neutral states")
@@ -132,7 +175,39 @@ Options::Options(int argc, char * const argv[]):
                 ("negative-color", value<std::string>(), "Color for showing negative states")
                 ("background-color", value<std::string>()->default_value("#00000000"), "Color for showing neutral states")
                 ("input-millis", value_for(inputMillis_), "Milliseconds for which an input is shown in movie mode")
-                ("dump,d", value<std::string>(&dumpPath), "dump convolutional images in this directory");
+                ("idle-timeout", value_for(idleTimeout_), "Seconds without input before animations pause, 0 to never pause")
+                ("vram-budget", value_for(vramBudget_), "GPU memory budget for loaded inputs in MiB, 0 for unlimited")
+                ("texture-budget", value_for(textureBudget_), "GPU memory budget for full resolution feature map tiles in MiB, 0 for unlimited")
+                ("input-window", value_for(inputWindow_), "Inputs to keep built on each side of the current one, 0 to keep all")
+                ("activation-cache", value_for(activationCache_), "Inputs to keep activations for outside the window")
+                ("layer-stats", bool_switch(&layerStats_), "Time every layer, and show forward time and memory usage next to the layer names")
+                ("index", value<std::string>(&indexPath_), "index from fmri-aggregate, to show the top inputs of the selected node")
+                ("statistic", value<std::string>(&statistic_), "treat the inputs as files from fmri-aggregate, and show this statistic: mean, variance, max or sparsity")
+                ("dump,d", value<std::string>(&dumpPath), "dump convolutional images in this directory")
+                ("dump-format", value_for(dumpFormat), "image format for dumps, png or pgm (uncompressed, fastest)")
+                ("dump-compression", value_for(dumpCompression), "PNG compression level for dumps, 0-9")
+                ("dump-threads", value_for(dumpThreads), "threads for writing dumps, 0 for one per core")
+                ("dump-mosaic", bool_switch(&dumpMosaic), "dump all channels of a layer as a single tiled image")
+                ("export", value<std::string>(&exportPath), "export the activations of every layer as .npy files in this directory")
+                ("trace", value<std::string>(&tracePath_), "write a Chrome trace of loading and rendering to this file");
+
+        options_description offscreen("Offscreen rendering");
+        offscreen.add_options()
+                ("offscreen", value<std::string>(&offscreenPath_), "render every input to an image in this directory, without a window")
+                ("camera-position", value<std::string>()->default_value("0,0,3"), "camera position x,y,z")
+                ("camera-angle", value<std::string>()->default_value("0,0"), "camera angle yaw,pitch in degrees")
+                ("animation-time", value_for(animationTime_), "point in the interaction animation to render, 0..1")
+                ("frame-size", value<std::string>()->default_value("1280x720"), "size of rendered images, WIDTHxHEIGHT")
+                ("encode-threads", value_for(encodeThreads_), "threads for writing images, 0 for one per core");
+        desc.add(offscreen);
+
+        options_description perf("Performance testing");
+        perf.add_options()
+                ("perf", value<std::string>(&perfPath_), "time loading and rendering every input without a window, and write the results as JSON to this file")
+                ("perf-baseline", value<std::string>(&perfBaseline_), "compare the results to this earlier JSON file, and fail on regressions")
+                ("perf-tolerance", value_for(perfTolerance_), "allowed relative slowdown compared to the baseline")
+                ("perf-runs", value_for(perfRuns_), "number of runs, the median of which is reported");
+        desc.add(perf);
 
         cli.add(desc);
         options_description composed = cli;
@@ -163,17 +238,20 @@ Options::Options(int argc, char * const argv[]):
         use_color(vm, "positive-color", POSITIVE_COLOR);
         use_color(vm, "negative-color", NEGATIVE_COLOR);
 
-        if (vm.count("background-color")) {
-            Color bg;
-            parse_color(vm["background-color"].as<std::string>(), bg);
-            glClearColor(bg[0], bg[1], bg[2], bg[3]);
-        }
+        use_color(vm, "background-color", backgroundColor_);
+        parse_list(vm["camera-position"].as<std::string>(), ',', cameraPosition_);
+        parse_list(vm["camera-angle"].as<std::string>(), ',', cameraAngle_);
+        parse_list(vm["frame-size"].as<std::string>(), 'x', frameSize_);
+        PNGDumper::parseFormat(dumpFormat);
+        if (!statistic_.empty()) ActivationStatistics::parseStatistic(statistic_);
 
         // Sanity checks
         check_file(modelPath);
         check_file(weightsPath);
         if (!meansPath.empty()) check_file(meansPath);
         if (!labelsPath.empty()) check_file(labelsPath);
+        if (!perfBaseline_.empty()) check_file(perfBaseline_);
+        if (!indexPath_.empty()) check_file(indexPath_);
         std::for_each(inputPaths.begin(), inputPaths.end(), check_file);
         return;
     } catch (required_option& e) {
@@ -189,6 +267,35 @@ Options::Options(int argc, char * const argv[]):
     std::exit(1);
 }
 
+bool Options::needsWindow(int argc, char *const argv[])
+{
+    using namespace boost::program_options;
+
+    options_description modes;
+    modes.add_options()
+            ("brain-mode,b", "")
+            ("help,h", "")
+            ("offscreen", value<std::string>())
+            ("perf", value<std::string>());
+
+    variables_map vm;
+    try {
+        store(command_line_parser(argc, argv).options(modes).allow_unregistered().run(), vm);
+        if (vm.count("brain-mode")) {
+            if (auto config = get_xdg_config(BRAIN_CONFIG_FILE); config.good()) {
+                store(parse_config_file(config, modes, true), vm);
+            }
+        }
+        if (auto config = get_xdg_config(MAIN_CONFIG_FILE); config.good()) {
+            store(parse_config_file(config, modes, true), vm);
+        }
+    } catch (std::exception&) {
+        // Reported by the full parse.
+    }
+
+    return !vm.count("help") && !vm.count("offscreen") && !vm.count("perf");
+}
+
 const string &Options::model() const
 {
     return modelPath;
@@ -223,7 +330,16 @@ std::optional<PNGDumper> Options::imageDumper() const
     if (dumpPath.empty()) {
         return std::nullopt;
     } else {
-        return PNGDumper(dumpPath);
+        return PNGDumper(dumpPath, PNGDumper::parseFormat(dumpFormat), dumpCompression, dumpThreads, dumpMosaic);
+    }
+}
+
+std::optional<NpyExporter> Options::tensorExporter() const
+{
+    if (exportPath.empty()) {
+        return std::nullopt;
+    } else {
+        return NpyExporter(exportPath);
     }
 }
 
@@ -242,12 +358,121 @@ float Options::interactionTransparency() const
     return interactionTransparency_;
 }
 
+float Options::activationThreshold() const
+{
+    return activationThreshold_;
+}
+
 bool Options::brainMode() const
 {
     return brainMode_;
 }
 
+bool Options::layerStats() const
+{
+    return layerStats_;
+}
+
+const string &Options::indexPath() const
+{
+    return indexPath_;
+}
+
+std::optional<ActivationStatistics::Statistic> Options::statistic() const
+{
+    if (statistic_.empty()) {
+        return std::nullopt;
+    }
+
+    return ActivationStatistics::parseStatistic(statistic_);
+}
+
 int Options::inputMillis() const
 {
     return inputMillis_;
 }
+
+std::size_t Options::vramBudget() const
+{
+    return vramBudget_ * 1024 * 1024;
+}
+
+std::size_t Options::textureBudget() const
+{
+    return textureBudget_ * 1024 * 1024;
+}
+
+int Options::idleTimeout() const
+{
+    return idleTimeout_;
+}
+
+const Color &Options::backgroundColor() const
+{
+    return backgroundColor_;
+}
+
+const string &Options::tracePath() const
+{
+    return tracePath_;
+}
+
+std::size_t Options::inputWindow() const
+{
+    return inputWindow_;
+}
+
+std::size_t Options::activationCache() const
+{
+    return activationCache_;
+}
+
+const string &Options::offscreenPath() const
+{
+    return offscreenPath_;
+}
+
+const std::array<float, 3> &Options::cameraPosition() const
+{
+    return cameraPosition_;
+}
+
+const std::array<float, 2> &Options::cameraAngle() const
+{
+    return cameraAngle_;
+}
+
+float Options::animationTime() const
+{
+    return animationTime_;
+}
+
+const std::array<int, 2> &Options::frameSize() const
+{
+    return frameSize_;
+}
+
+int Options::encodeThreads() const
+{
+    return encodeThreads_;
+}
+
+const string &Options::perfPath() const
+{
+    return perfPath_;
+}
+
+const string &Options::perfBaseline() const
+{
+    return perfBaseline_;
+}
+
+float Options::perfTolerance() const
+{
+    return perfTolerance_;
+}
+
+int Options::perfRuns() const
+{
+    return perfRuns_;
+}
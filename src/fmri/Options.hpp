@@ -1,10 +1,13 @@
 #pragma once
 
+#include <array>
 #include <optional>
 #include <string>
 #include <vector>
 
 #include "utils.hpp"
+#include "ActivationStatistics.hpp"
+#include "NpyExporter.hpp"
 #include "PNGDumper.hpp"
 
 namespace fmri {
@@ -16,30 +19,127 @@ namespace fmri {
     public:
         Options(const int argc, char *const argv[]);
 
+        /**
+         * Check whether the arguments ask for the interactive viewer.
+         *
+         * Only looks at the options that choose a mode, on the command line
+         * and in the config files. The window system has to be set up before
+         * the full parse, so it can take its own arguments out of argv.
+         *
+         * @return false when rendering offscreen, measuring performance or showing help.
+         */
+        static bool needsWindow(int argc, char *const argv[]);
+
         const string& model() const;
         const string& weights() const;
         const string& means() const;
         const Color& pathColor() const;
         std::optional<vector<string>> labels() const;
         std::optional<fmri::PNGDumper> imageDumper() const;
+        std::optional<fmri::NpyExporter> tensorExporter() const;
         float layerTransparency() const;
         float interactionTransparency() const;
+        /**
+         * @return Fraction of the largest activation in a layer that nodes need to count as activated.
+         */
+        float activationThreshold() const;
 
         const vector<string>& inputs() const;
         bool brainMode() const;
+        /**
+         * @return Whether to time every layer and show layer costs in the scene.
+         */
+        bool layerStats() const;
+        /**
+         * @return Statistic to show when the inputs are activation statistics files, if they are.
+         */
+        std::optional<ActivationStatistics::Statistic> statistic() const;
+        /**
+         * @return Index of the top inputs per node from fmri-aggregate, or empty if none.
+         */
+        const string& indexPath() const;
         int inputMillis() const;
+        std::size_t vramBudget() const;
+        /**
+         * @return Budget for full resolution feature map tiles in bytes, 0 for unlimited.
+         */
+        std::size_t textureBudget() const;
+        int idleTimeout() const;
+        const Color& backgroundColor() const;
+        /**
+         * @return File to write a Chrome trace to, or empty to disable tracing.
+         */
+        const string& tracePath() const;
+        /**
+         * @return Number of inputs kept materialised on each side of the current one, 0 for all.
+         */
+        std::size_t inputWindow() const;
+        /**
+         * @return Number of inputs to keep the activations of when they leave the window.
+         */
+        std::size_t activationCache() const;
+
+        /**
+         * @return Directory to render images to, or empty for interactive use.
+         */
+        const string& offscreenPath() const;
+        const std::array<float, 3>& cameraPosition() const;
+        const std::array<float, 2>& cameraAngle() const;
+        float animationTime() const;
+        const std::array<int, 2>& frameSize() const;
+        int encodeThreads() const;
+
+        /**
+         * @return File to write performance measurements to, or empty for normal use.
+         */
+        const string& perfPath() const;
+        /**
+         * @return File with measurements to compare against, or empty to skip the comparison.
+         */
+        const string& perfBaseline() const;
+        /**
+         * @return Allowed relative slowdown compared to the baseline.
+         */
+        float perfTolerance() const;
+        int perfRuns() const;
 
     private:
         float layerTransparency_;
         float interactionTransparency_;
+        float activationThreshold_;
         Color pathColor_;
         string modelPath;
         string weightsPath;
         string meansPath;
         string labelsPath;
         string dumpPath;
+        string dumpFormat;
+        int dumpCompression;
+        int dumpThreads;
+        bool dumpMosaic;
+        string exportPath;
         vector<string> inputPaths;
         bool brainMode_;
+        bool layerStats_;
+        string statistic_;
+        string indexPath_;
         int inputMillis_;
+        std::size_t vramBudget_;
+        std::size_t textureBudget_;
+        int idleTimeout_;
+        Color backgroundColor_;
+        string tracePath_;
+        std::size_t inputWindow_;
+        std::size_t activationCache_;
+        string offscreenPath_;
+        std::array<float, 3> cameraPosition_;
+        std::array<float, 2> cameraAngle_;
+        float animationTime_;
+        std::array<int, 2> frameSize_;
+        int encodeThreads_;
+        string perfPath_;
+        string perfBaseline_;
+        float perfTolerance_;
+        int perfRuns_;
     };
 }
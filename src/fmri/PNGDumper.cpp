@@ -1,71 +1,181 @@
+#include <algorithm>
 #include <cstring>
+#include <fstream>
+#include <stdexcept>
 
 #include <glog/logging.h>
-#include <sys/stat.h>
 #include <opencv2/core/mat.hpp>
 #include <opencv2/imgcodecs.hpp>
 
 #include "PNGDumper.hpp"
+#include "Tracer.hpp"
 
 using namespace fmri;
 using namespace std;
 
-static void ensureDir(const string& dir)
+PNGDumper::PNGDumper(string_view baseDir, Format format, int compression, std::size_t threads, bool mosaic) :
+        baseDir_(baseDir),
+        format(format),
+        mosaic(mosaic),
+        queue(std::make_unique<WorkQueue>(threads))
 {
-    struct stat s;
-    if (stat(dir.c_str(), &s) == 0) {
-        CHECK(S_ISDIR(s.st_mode)) << dir << " already exists and is not a directory." << endl;
-        return;
-    }
+    ensureDirectory(baseDir_);
 
-    switch (errno) {
-        case ENOENT:
-            PCHECK(mkdir(dir.c_str(), 0777) == 0) << "Couldn't create directory";
-            return;
+    switch (format) {
+        case Format::PNG:
+            parameters = {cv::IMWRITE_PNG_COMPRESSION, std::clamp(compression, 0, 9)};
+            break;
 
-        default:
-            perror("Unusable dump dir");
+        case Format::PGM:
+            parameters = {cv::IMWRITE_PXM_BINARY, 1};
             break;
     }
 }
 
-PNGDumper::PNGDumper(string_view baseDir) :
-        baseDir_(baseDir)
+void PNGDumper::dump(std::shared_ptr<const std::vector<LayerData>> layers, std::size_t input)
+{
+    for (auto &layer : *layers) {
+        if (layer.shape().size() != 4) {
+            LOG(INFO) << "Unable to dump layer " << layer.name() << " as images.";
+            continue;
+        }
+
+        if (mosaic) {
+            // The tile layout is the same for every input, so the index is written once.
+            if (indexedLayers.insert(layer.name()).second) {
+                queue->submit([this, layers, &layer]() {
+                    dumpMosaicIndex(layer);
+                });
+            }
+            for (int image = 0; image < layer.shape()[0]; ++image) {
+                queue->submit([this, layers, &layer, input, image]() {
+                    dumpMosaic(layer, input, image);
+                });
+            }
+            continue;
+        }
+
+        // Split large layers, so they are encoded in parallel.
+        const auto channels = layer.shape()[1];
+        for (int first = 0; first < channels; first += CHANNELS_PER_JOB) {
+            const auto last = std::min(channels, first + CHANNELS_PER_JOB);
+            queue->submit([this, layers, &layer, input, first, last]() {
+                dumpImageSeries(layer, input, first, last);
+            });
+        }
+    }
+}
+
+void PNGDumper::wait()
 {
-    ensureDir(baseDir_);
+    queue->wait();
 }
 
-void PNGDumper::dump(const LayerData &layerData)
+PNGDumper::Format PNGDumper::parseFormat(string_view format)
 {
-    if (layerData.shape().size() == 4) {
-        // We have a series of images.
-        dumpImageSeries(layerData);
+    if (format == "png") {
+        return Format::PNG;
+    } else if (format == "pgm") {
+        return Format::PGM;
     } else {
-        LOG(INFO) << "Unable to dump this type of layer to png.";
+        throw std::invalid_argument("Unknown dump format: " + string(format));
+    }
+}
+
+const char *PNGDumper::extension() const
+{
+    switch (format) {
+        case Format::PGM:
+            return "pgm";
+
+        default:
+            return "png";
     }
 }
 
-void PNGDumper::dumpImageSeries(const LayerData &layer)
+/**
+ * Rescale a single channel to the full 8-bit range.
+ *
+ * @param data Start of the channel.
+ * @param buffer Float image of the channel size, used as scratch space.
+ * @param quantised Output image.
+ */
+static void quantiseChannel(const float *data, cv::Mat &buffer, cv::Mat &quantised)
+{
+    std::copy_n(data, buffer.rows * buffer.cols, buffer.begin<float>());
+    rescale(buffer.begin<float>(), buffer.end<float>(), 0, 255);
+    buffer.convertTo(quantised, CV_8U);
+}
+
+void PNGDumper::dumpImageSeries(const LayerData &layer, std::size_t input, int firstChannel, int lastChannel) const
 {
+    Tracer::Span span("dump", layer.name());
     const auto& shape = layer.shape();
     const auto images = shape[0], channels = shape[1], height = shape[2], width = shape[3];
     const auto imagePixels = width * height;
 
-    cv::Mat image(width, height, CV_32FC1);
-
-    auto data = layer.data();
+    cv::Mat image(height, width, CV_32FC1);
+    cv::Mat quantised;
 
     for (int i = 0; i < images; ++i) {
-        for (int j = 0; j < channels; ++j) {
+        auto data = layer.data() + (i * channels + firstChannel) * imagePixels;
+        for (int j = firstChannel; j < lastChannel; ++j) {
             char pathBuf[PATH_MAX];
-            std::copy_n(data, imagePixels, image.begin<float>());
-            rescale(image.begin<float>(), image.end<float>(), 0, 255);
-            std::snprintf(pathBuf, sizeof(pathBuf), "%s/%s-%d-%d.png", baseDir_.c_str(), layer.name().c_str(), i, j);
+            quantiseChannel(data, image, quantised);
+            std::snprintf(pathBuf, sizeof(pathBuf), "%s/%zu-%s-%d-%d.%s", baseDir_.c_str(), input, layer.name().c_str(), i, j,
+                          extension());
 
-            cv::imwrite(pathBuf, image);
+            cv::imwrite(pathBuf, quantised, parameters);
 
             data += imagePixels;
         }
     }
 }
 
+void PNGDumper::dumpMosaic(const LayerData &layer, std::size_t input, int image) const
+{
+    Tracer::Span span("dump mosaic", layer.name());
+    const auto& shape = layer.shape();
+    const auto channels = shape[1], height = shape[2], width = shape[3];
+    const auto imagePixels = width * height;
+    // Same grid as the layer visualisation, so tiles are easy to match up.
+    const auto columns = numCols(channels);
+    const auto rows = channels / columns;
+
+    cv::Mat buffer(height, width, CV_32FC1);
+    cv::Mat quantised;
+    cv::Mat mosaic(rows * height, columns * width, CV_8UC1);
+
+    auto data = layer.data() + image * channels * imagePixels;
+    for (int j = 0; j < channels; ++j) {
+        quantiseChannel(data, buffer, quantised);
+        quantised.copyTo(mosaic(cv::Rect((j % columns) * width, (j / columns) * height, width, height)));
+        data += imagePixels;
+    }
+
+    char pathBuf[PATH_MAX];
+    std::snprintf(pathBuf, sizeof(pathBuf), "%s/%zu-%s-%d.%s", baseDir_.c_str(), input, layer.name().c_str(), image,
+                  extension());
+    cv::imwrite(pathBuf, mosaic, parameters);
+}
+
+void PNGDumper::dumpMosaicIndex(const LayerData &layer) const
+{
+    const auto& shape = layer.shape();
+    const auto channels = shape[1], height = shape[2], width = shape[3];
+    const auto columns = numCols(channels);
+
+    char pathBuf[PATH_MAX];
+    std::snprintf(pathBuf, sizeof(pathBuf), "%s/%s.tsv", baseDir_.c_str(), layer.name().c_str());
+    std::ofstream index(pathBuf);
+    if (!index) {
+        LOG(ERROR) << "Failed to write mosaic index " << pathBuf;
+        return;
+    }
+
+    index << "channel\tx\ty\twidth\theight\n";
+    for (int j = 0; j < channels; ++j) {
+        index << j << '\t' << (j % columns) * width << '\t' << (j / columns) * height << '\t'
+              << width << '\t' << height << '\n';
+    }
+}
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <memory>
+#include <set>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "LayerData.hpp"
+#include "WorkQueue.hpp"
 #include "utils.hpp"
 
 namespace fmri
@@ -11,17 +15,68 @@ namespace fmri
     using std::string;
     using std::string_view;
 
+    /**
+     * Writes every channel of image-like layers to an image file.
+     *
+     * In mosaic mode, all channels of a layer are tiled into a single
+     * image instead, with a tab-separated index of the tile positions.
+     *
+     * Encoding happens on a pool of worker threads, so dumping does not
+     * hold up loading unless the pool falls behind.
+     */
     class PNGDumper
     {
     public:
-        PNGDumper(string_view baseDir);
+        enum class Format
+        {
+            PNG,
+            /** Uncompressed binary PGM, much faster to write than PNG. */
+            PGM,
+        };
 
-        void dump(const LayerData& layerData);
+        /**
+         * @param baseDir Directory to write to, created if needed.
+         * @param format Image format to write.
+         * @param compression PNG compression level, 0-9.
+         * @param threads Number of encoding threads, 0 for one per core.
+         * @param mosaic Whether to write one tiled image per layer rather than one per channel.
+         */
+        explicit PNGDumper(string_view baseDir, Format format = Format::PNG, int compression = 3, std::size_t threads = 0, bool mosaic = false);
+
+        /**
+         * Queue all image-like layers of an input for dumping.
+         *
+         * The layers are kept alive until they have been written. This
+         * only blocks when too many layers are waiting already. Only call
+         * this from a single thread.
+         *
+         * @param layers
+         * @param input Index of the input, to tell the files of different inputs apart.
+         */
+        void dump(std::shared_ptr<const std::vector<LayerData>> layers, std::size_t input);
+
+        /**
+         * Wait until everything queued has been written.
+         */
+        void wait();
+
+        static Format parseFormat(string_view format);
 
     private:
-        string baseDir_;
+        // Number of channels written by a single job.
+        static constexpr int CHANNELS_PER_JOB = 64;
 
-        void dumpImageSeries(const LayerData &data);
+        string baseDir_;
+        Format format;
+        bool mosaic;
+        std::vector<int> parameters;
+        std::unique_ptr<WorkQueue> queue;
+        // Layers with a mosaic index queued already.
+        std::set<string> indexedLayers;
 
+        void dumpImageSeries(const LayerData &data, std::size_t input, int firstChannel, int lastChannel) const;
+        void dumpMosaic(const LayerData &layer, std::size_t input, int image) const;
+        void dumpMosaicIndex(const LayerData &layer) const;
+        const char* extension() const;
     };
 }
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include "PagePool.hpp"
+
+using namespace fmri;
+
+// Enough to fill the screen with 224x224 tiles within a few frames.
+static constexpr std::size_t DEFAULT_UPLOAD_LIMIT = 32;
+
+PagePool::PagePool() noexcept :
+        budget_(0),
+        residentBytes_(0),
+        uploadLimit(DEFAULT_UPLOAD_LIMIT),
+        uploads(0),
+        frame(0)
+{
+}
+
+PagePool &PagePool::instance()
+{
+    static PagePool pool;
+    return pool;
+}
+
+void PagePool::setBudget(std::size_t budget)
+{
+    budget_ = budget;
+}
+
+void PagePool::setUploadLimit(std::size_t pages)
+{
+    uploadLimit = pages;
+}
+
+void PagePool::beginFrame()
+{
+    ++frame;
+    uploads = 0;
+    // Shrink to the budget, in case it was lowered.
+    makeRoom(0);
+}
+
+const Texture *PagePool::page(std::uint64_t owner, int channel, const std::uint8_t *pixels, int width, int height)
+{
+    if (auto it = pages.find({owner, channel}); it != pages.end()) {
+        lru.splice(lru.begin(), lru, it->second);
+        it->second->lastUse = frame;
+        return &it->second->texture;
+    }
+
+    if (uploadLimit != 0 && uploads >= uploadLimit) {
+        return nullptr;
+    }
+
+    const auto size = static_cast<std::size_t>(width) * height;
+    auto data = std::make_unique<std::uint8_t[]>(size);
+    std::copy_n(pixels, size, data.get());
+    Texture texture(std::move(data), width, height, GL_LUMINANCE);
+
+    const auto bytes = texture.memoryUsage();
+    if (!makeRoom(bytes)) {
+        return nullptr;
+    }
+
+    texture.configure(GL_TEXTURE_2D_ARRAY);
+    ++uploads;
+    residentBytes_ += bytes;
+    lru.push_front({owner, channel, std::move(texture), bytes, frame});
+    pages.emplace(std::make_pair(owner, channel), lru.begin());
+
+    return &lru.front().texture;
+}
+
+void PagePool::release(std::uint64_t owner)
+{
+    const auto first = pages.lower_bound({owner, INT_MIN});
+    const auto last = pages.upper_bound({owner, INT_MAX});
+    for (auto it = first; it != last; ++it) {
+        residentBytes_ -= it->second->bytes;
+        lru.erase(it->second);
+    }
+    pages.erase(first, last);
+}
+
+void PagePool::clear()
+{
+    pages.clear();
+    lru.clear();
+    residentBytes_ = 0;
+}
+
+std::uint64_t PagePool::newOwner()
+{
+    // Virtual textures are created on the loader thread.
+    static std::atomic<std::uint64_t> next(1);
+    return next++;
+}
+
+std::size_t PagePool::budget() const
+{
+    return budget_;
+}
+
+std::size_t PagePool::residentBytes() const
+{
+    return residentBytes_;
+}
+
+/**
+ * Evict pages not used in this frame until the given number of bytes fits in the budget.
+ *
+ * @return Whether the bytes fit.
+ */
+bool PagePool::makeRoom(std::size_t bytes)
+{
+    if (budget_ == 0) {
+        return true;
+    }
+
+    while (residentBytes_ + bytes > budget_ && !lru.empty() && lru.back().lastUse != frame) {
+        auto &victim = lru.back();
+        residentBytes_ -= victim.bytes;
+        pages.erase({victim.owner, victim.channel});
+        lru.pop_back();
+    }
+
+    return residentBytes_ + bytes <= budget_;
+}
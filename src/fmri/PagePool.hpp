@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <utility>
+#include "Texture.hpp"
+
+namespace fmri
+{
+    /**
+     * Fixed budget of GPU memory for full resolution feature map tiles.
+     *
+     * Pages are single channels of a VirtualTexture, uploaded when they
+     * are first drawn close enough to need them. When the budget is full,
+     * the least recently drawn pages are evicted, but never those drawn
+     * in the current frame. Uploads per frame are limited, so moving
+     * closer to a large layer streams its tiles in over a few frames
+     * instead of stalling a single one.
+     *
+     * All methods should be called from the thread owning the GL context.
+     */
+    class PagePool
+    {
+    public:
+        static PagePool& instance();
+
+        /**
+         * @param budget Memory budget in bytes. 0 means unlimited.
+         */
+        void setBudget(std::size_t budget);
+        /**
+         * @param pages Number of pages to upload per frame at most. 0 means unlimited.
+         */
+        void setUploadLimit(std::size_t pages);
+
+        /**
+         * Start a new frame, resetting the upload limit and evicting pages over the budget.
+         */
+        void beginFrame();
+
+        /**
+         * Get a page, uploading it if needed and possible.
+         *
+         * @param owner Identifier of the virtual texture, from newOwner().
+         * @param channel Channel of the virtual texture.
+         * @param pixels Quantised pixels of the channel, only read when uploading.
+         * @param width
+         * @param height
+         * @return The page as a single layer GL_TEXTURE_2D_ARRAY, or nullptr if not resident.
+         */
+        const Texture* page(std::uint64_t owner, int channel, const std::uint8_t* pixels, int width, int height);
+
+        /**
+         * Drop all pages of a virtual texture.
+         */
+        void release(std::uint64_t owner);
+
+        /**
+         * Drop all pages, before the context is destroyed.
+         */
+        void clear();
+
+        /**
+         * @return A new identifier for a virtual texture.
+         */
+        static std::uint64_t newOwner();
+
+        std::size_t budget() const;
+        std::size_t residentBytes() const;
+
+    private:
+        struct Page
+        {
+            std::uint64_t owner;
+            int channel;
+            Texture texture;
+            std::size_t bytes;
+            std::uint64_t lastUse;
+        };
+
+        std::size_t budget_;
+        std::size_t residentBytes_;
+        std::size_t uploadLimit;
+        std::size_t uploads;
+        std::uint64_t frame;
+        // Resident pages, most recently used first.
+        std::list<Page> lru;
+        std::map<std::pair<std::uint64_t, int>, std::list<Page>::iterator> pages;
+
+        PagePool() noexcept;
+
+        bool makeRoom(std::size_t bytes);
+    };
+}
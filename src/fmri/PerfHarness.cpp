@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <glog/logging.h>
+#include "PerfHarness.hpp"
+#include "RenderingState.hpp"
+#include "Simulator.hpp"
+#include "utils.hpp"
+#include "visualisations.hpp"
+
+using namespace fmri;
+
+static double millis(PerfHarness::clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+PerfHarness::PerfHarness(const Options &options) :
+        options(options)
+{
+}
+
+bool PerfHarness::run(const OffscreenContext &context, clock::duration startup)
+{
+    record("startup_ms", startup);
+
+    for (int i = 0; i < options.perfRuns(); ++i) {
+        LOG(INFO) << "Performance run " << i + 1 << " of " << options.perfRuns();
+        runOnce(context);
+    }
+
+    const auto results = medians();
+    write(results);
+
+    return options.perfBaseline().empty() || compare(results);
+}
+
+void PerfHarness::runOnce(const OffscreenContext &context)
+{
+    auto start = clock::now();
+    Simulator simulator(options.model(), options.weights(), options.means());
+    record("model_load_ms", clock::now() - start);
+
+    const auto labels = options.labels();
+    clock::duration simulate{}, build{}, upload{}, frame{};
+
+    const auto& inputs = options.inputs();
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        const auto& input = inputs[i];
+        start = clock::now();
+        auto data = std::make_shared<const std::vector<LayerData>>(simulator.simulate(input));
+        const auto simulated = clock::now();
+        auto visualisation = buildVisualisation(input, std::move(data), simulator.layerInfo(), labels);
+        const auto built = clock::now();
+        const auto [uploadTime, frameTime] = RenderingState::instance().renderOnce(options, context, std::move(visualisation));
+
+        // The index keeps inputs that are given more than once apart.
+        const auto prefix = "input/" + std::to_string(i) + "/" + input + "/";
+        record(prefix + "simulate_ms", simulated - start);
+        record(prefix + "build_ms", built - simulated);
+        record(prefix + "upload_ms", uploadTime);
+        record(prefix + "first_frame_ms", frameTime);
+
+        simulate += simulated - start;
+        build += built - simulated;
+        upload += uploadTime;
+        frame += frameTime;
+    }
+
+    record("simulate_ms", simulate);
+    record("build_ms", build);
+    record("upload_ms", upload);
+    record("first_frame_ms", frame);
+}
+
+void PerfHarness::record(const std::string &metric, clock::duration duration)
+{
+    samples[metric].push_back(millis(duration));
+}
+
+std::map<std::string, double> PerfHarness::medians() const
+{
+    std::map<std::string, double> results;
+    for (auto [metric, values] : samples) {
+        auto middle = values.begin() + values.size() / 2;
+        std::nth_element(values.begin(), middle, values.end());
+        results[metric] = *middle;
+    }
+
+    return results;
+}
+
+void PerfHarness::write(const std::map<std::string, double> &results) const
+{
+    std::ofstream out(options.perfPath());
+    CHECK(out) << "Failed to open " << options.perfPath();
+
+    // Written directly, since property trees only hold strings and would quote the numbers.
+    out << std::fixed << std::setprecision(3) << "{\n  \"runs\": " << options.perfRuns() << ",\n  \"metrics\": {";
+    bool first = true;
+    for (auto &[metric, value] : results) {
+        out << (first ? "\n    " : ",\n    ");
+        writeJsonString(out, metric);
+        out << ": " << value;
+        first = false;
+    }
+    out << "\n  }\n}\n";
+    CHECK(out) << "Failed to write " << options.perfPath();
+
+    LOG(INFO) << "Wrote " << results.size() << " measurements to " << options.perfPath();
+}
+
+bool PerfHarness::compare(const std::map<std::string, double> &results) const
+{
+    boost::property_tree::ptree baseline;
+    boost::property_tree::read_json(options.perfBaseline(), baseline);
+
+    bool passed = true;
+    for (auto &[metric, value] : baseline.get_child("metrics")) {
+        const auto expected = value.get_value<double>();
+        const auto result = results.find(metric);
+        if (result == results.end()) {
+            LOG(ERROR) << metric << ": missing from results";
+            passed = false;
+            continue;
+        }
+
+        const auto limit = std::max(expected * (1 + options.perfTolerance()), expected + NOISE_MILLIS);
+        if (result->second > limit) {
+            LOG(ERROR) << metric << ": " << result->second << " ms, baseline " << expected << " ms";
+            passed = false;
+        } else {
+            LOG(INFO) << metric << ": " << result->second << " ms, baseline " << expected << " ms";
+        }
+    }
+
+    LOG_IF(ERROR, !passed) << "Performance regressed compared to " << options.perfBaseline();
+    return passed;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include "Options.hpp"
+#include "OffscreenContext.hpp"
+
+namespace fmri
+{
+    /**
+     * Deterministic, window-less performance test.
+     *
+     * Loads the network and renders every input offscreen on a single
+     * thread, timing each step. Every run starts from scratch, and the
+     * median over all runs is reported. The results are written as JSON,
+     * and can be compared against the results of an earlier build.
+     */
+    class PerfHarness
+    {
+    public:
+        typedef std::chrono::steady_clock clock;
+
+        /**
+         * @param options Options to run with. The network and inputs should not change between builds.
+         */
+        explicit PerfHarness(const Options& options);
+
+        /**
+         * Run all measurements, write them, and compare them to the baseline.
+         *
+         * @param context Active offscreen context to render with.
+         * @param startup Time taken to start up before the harness was created.
+         * @return Whether no measurement regressed compared to the baseline.
+         */
+        bool run(const OffscreenContext& context, clock::duration startup);
+
+    private:
+        // Differences smaller than this are considered noise, whatever the tolerance.
+        static constexpr double NOISE_MILLIS = 1;
+
+        const Options& options;
+        // Measured values of every metric, one per run.
+        std::map<std::string, std::vector<double>> samples;
+
+        void runOnce(const OffscreenContext& context);
+        void record(const std::string& metric, clock::duration duration);
+
+        std::map<std::string, double> medians() const;
+        void write(const std::map<std::string, double>& results) const;
+        bool compare(const std::map<std::string, double>& results) const;
+    };
+}
@@ -4,6 +4,7 @@
 #include "PoolingLayerAnimation.hpp"
 #include "glutils.hpp"
 #include "MultiImageVisualisation.hpp"
+#include "TextureCache.hpp"
 
 using namespace std;
 using namespace fmri;
@@ -11,8 +12,7 @@ using namespace fmri;
 PoolingLayerAnimation::PoolingLayerAnimation(const LayerData &prevData, const LayerData &curData,
                                              const std::vector<float> &prevPositions,
                                              const std::vector<float> &curPositions) :
-        original(loadTextureForData(prevData)),
-        downSampled(loadTextureForData(curData)),
+        original(TextureCache::instance().get(prevData.data(), prevData.shape().at(2), prevData.shape().at(3), prevData.shape().at(1))),
         startingPositions(MultiImageVisualisation::getVertices(prevPositions)),
         deltas(startingPositions.size()),
         textureCoordinates(MultiImageVisualisation::getTexCoords(prevPositions.size() / 3))
@@ -32,22 +32,39 @@ void PoolingLayerAnimation::draw(float timeStep)
 {
     auto& vertexBuffer = animate(startingPositions, deltas, timeStep);
 
-    drawImageTiles(vertexBuffer.size() / 3, vertexBuffer.data(), textureCoordinates.data(), original, getAlpha());
+    original->draw(vertexBuffer.size() / 3, vertexBuffer.data(), textureCoordinates.data(), getAlpha());
 }
 
-Texture PoolingLayerAnimation::loadTextureForData(const LayerData &data)
+void PoolingLayerAnimation::glLoad()
 {
-    CHECK_EQ(data.shape().size(), 4) << "Layer should be image-like";
-    CHECK_EQ(data.shape()[0], 1) << "Only single images supported";
+    Drawable::glLoad();
 
-    auto channels = data.shape()[1], width = data.shape()[2], height = data.shape()[3];
-    return Texture(data.data(), width, height * channels, GL_LUMINANCE, channels);
+    original->configure();
 }
 
-void PoolingLayerAnimation::glLoad()
+void PoolingLayerAnimation::glUnload()
 {
-    Drawable::glLoad();
+    Drawable::glUnload();
+
+    original->unload();
+}
+
+void PoolingLayerAnimation::glReplace(Drawable &previous)
+{
+    if (auto other = dynamic_cast<PoolingLayerAnimation *>(&previous)) {
+        Drawable::glLoad();
+        original->configure(*other->original);
+    } else {
+        Drawable::glReplace(previous);
+    }
+}
 
-    original.configure(GL_TEXTURE_2D);
-    downSampled.configure(GL_TEXTURE_2D);
+std::size_t PoolingLayerAnimation::glMemoryUsage() const
+{
+    return TextureCache::sharedMemoryUsage(original);
+}
+
+std::size_t PoolingLayerAnimation::vertexBytes() const
+{
+    return Drawable::vertexBytes() + bytesOf(startingPositions) + bytesOf(deltas) + bytesOf(textureCoordinates);
 }
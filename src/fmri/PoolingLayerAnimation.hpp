@@ -2,7 +2,8 @@
 
 #include "Animation.hpp"
 #include "LayerData.hpp"
-#include "Texture.hpp"
+#include <memory>
+#include "VirtualTexture.hpp"
 
 namespace fmri
 {
@@ -15,14 +16,15 @@ namespace fmri
 
         void draw(float timeStep) override;
         void glLoad() override;
+        void glUnload() override;
+        void glReplace(Drawable& previous) override;
+        std::size_t glMemoryUsage() const override;
+        std::size_t vertexBytes() const override;
 
     private:
-        Texture original;
-        Texture downSampled;
+        std::shared_ptr<VirtualTexture> original;
         std::vector<float> startingPositions;
         std::vector<float> deltas;
         std::vector<float> textureCoordinates;
-
-        static Texture loadTextureForData(const LayerData& data);
     };
 }
@@ -1,5 +1,11 @@
 #include <GL/glut.h>
 #include <cmath>
+#include <climits>
+#include <numeric>
+#include <GL/glu.h>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
 #include <sstream>
 #include <iostream>
 #include "RenderingState.hpp"
@@ -8,6 +14,17 @@
 #include "glutils.hpp"
 #include "Simulator.hpp"
 #include "LabelVisualisation.hpp"
+#include "InputLayerVisualisation.hpp"
+#include "FrameScheduler.hpp"
+#include "FrameProfiler.hpp"
+#include "WorkQueue.hpp"
+#include "Tracer.hpp"
+#include "PagePool.hpp"
+#include "Colormap.hpp"
+
+#ifdef FREEGLUT
+#include <GL/freeglut.h>
+#endif
 
 using namespace fmri;
 
@@ -16,6 +33,14 @@ static inline void toggle(bool &b)
     b = !b;
 }
 
+/**
+ * Change a setting in [0, 1] by a step.
+ */
+static inline void adjust(float &value, float step)
+{
+    value = std::clamp(value + step, 0.f, 1.f);
+}
+
 static float getFPS()
 {
     static int frames = 0;
@@ -44,9 +69,7 @@ static void updatePointSize(float dir)
     glPointSize(std::max(1.f, size));
 }
 
-static unsigned int loadingPct;
-
-static void renderLoadingScreen()
+static void renderLoadingScreen(const std::string& state)
 {
     glLoadIdentity();
     glTranslatef(0, 0, -4);
@@ -54,9 +77,6 @@ static void renderLoadingScreen()
     glColor3f(1, 1, 1);
     glutWireTeapot(1);
 
-    char state[1024];
-    std::snprintf(state, sizeof(state), "Loading... %u%%", loadingPct);
-
     auto pulse = std::cos(2 * M_PI * getAnimationStep(std::chrono::seconds(3)));
     pulse *= pulse;
     glColor3d(pulse, pulse, 0);
@@ -66,69 +86,6 @@ static void renderLoadingScreen()
     restorePerspectiveProjection();
 }
 
-typedef std::vector<std::vector<std::pair<std::unique_ptr<LayerVisualisation>, std::unique_ptr<Animation>>>> VisualisationList;
-
-static VisualisationList loadVisualisations(const Options& options)
-{
-    using namespace std;
-
-    Simulator simulator(options.model(), options.weights(), options.means());
-
-    const auto layerInfo = simulator.layerInfo();
-    auto labels = options.labels();
-
-    VisualisationList result;
-
-    auto dumper = options.imageDumper();
-
-    for (auto& input : options.inputs()) {
-        loadingPct = 100 * result.size() / options.inputs().size();
-        LOG(INFO) << "Simulating " << input;
-        auto item = simulator.simulate(input);
-
-        vector<unique_ptr<LayerVisualisation>> layers;
-        vector<unique_ptr<Animation>> animations;
-        LayerData* prevData = nullptr;
-
-        for (auto &layer : item) {
-            unique_ptr<LayerVisualisation> layerVisualisation(getVisualisationForLayer(layer, layerInfo.at(layer.name())));
-
-            if (prevData != nullptr) {
-                auto animation = getActivityAnimation(*prevData, layer, layerInfo.at(layer.name()), (*layers.rbegin())->nodePositions(), layerVisualisation->nodePositions());
-                animations.emplace_back(animation);
-            }
-
-            layers.emplace_back(move(layerVisualisation));
-            prevData = &layer;
-
-        }
-
-        VisualisationList::value_type dataSet;
-
-        if (labels) {
-            auto &last = *item.rbegin();
-            auto bestIndex = std::distance(last.data(), max_element(last.data(), last.data() + last.numEntries()));
-            LOG(INFO) << "Got answer: " << labels->at(bestIndex) << endl;
-            animations.emplace_back(new LabelVisualisation(layers.rbegin()->get()->nodePositions(), *prevData, labels.value()));
-        }
-
-        if (dumper) {
-            for (auto &layer : item) {
-                dumper->dump(layer);
-            }
-        }
-
-        for (auto i = 0u; i < layers.size(); ++i) {
-            auto interaction = i < animations.size() ? move(animations[i]) : nullptr;
-            dataSet.emplace_back(move(layers[i]), move(interaction));
-        }
-
-        result.push_back(move(dataSet));
-    }
-
-    return result;
-}
-
 void RenderingState::move(unsigned char key, bool sprint)
 {
     float speed = 0.5f;
@@ -162,10 +119,7 @@ void RenderingState::move(unsigned char key, bool sprint)
 
 void RenderingState::handleKey(unsigned char x)
 {
-    if (isLoading()) {
-        // Don't handle user input while loading.
-        return;
-    }
+    registerInteraction();
     switch (x) {
         case 'w':
         case 'a':
@@ -189,6 +143,7 @@ void RenderingState::handleKey(unsigned char x)
             break;
 
         case 'q':
+            glUnload();
             exit(0);
 
         case 'h':
@@ -207,6 +162,31 @@ void RenderingState::handleKey(unsigned char x)
             toggle(options.activatedOnly);
             break;
 
+        case '[':
+        case ']':
+            // Showing all nodes would hide the change.
+            options.activatedOnly = true;
+            adjust(options.activationThreshold, x == ']' ? THRESHOLD_STEP : -THRESHOLD_STEP);
+            break;
+
+        case ',':
+        case '.':
+            adjust(options.layerAlpha, x == '.' ? OPACITY_STEP : -OPACITY_STEP);
+            break;
+
+        case '<':
+        case '>':
+            adjust(options.interactionAlpha, x == '>' ? OPACITY_STEP : -OPACITY_STEP);
+            break;
+
+        case 'r':
+            revertEdits();
+            break;
+
+        case ' ':
+            FrameScheduler::instance().togglePaused();
+            break;
+
         case '+':
             updatePointSize(1);
             break;
@@ -229,6 +209,26 @@ std::string RenderingState::debugInfo() const
     buffer << "Pos(x,y,z) = (" << pos[0] << ", " << pos[1] << ", " << pos[2] << ")\n";
     buffer << "Angle(p,y) = (" << angle[0] << ", " << angle[1] << ")\n";
     buffer << "FPS = " << getFPS() << "\n";
+    buffer << "Frame time = " << std::chrono::duration<float, std::milli>(FrameScheduler::instance().frameDuration()).count() << " ms\n";
+    buffer << "Opacity = " << options.layerAlpha << " layers, " << options.interactionAlpha << " interactions\n";
+    if (options.activatedOnly) {
+        buffer << "Activation threshold = " << options.activationThreshold << "\n";
+    }
+    if (!isLoading()) {
+        constexpr auto MiB = 1024 * 1024;
+        buffer << "GPU memory = " << residency.residentBytes() / MiB << " MiB";
+        if (residency.budget() != 0) {
+            buffer << " / " << residency.budget() / MiB << " MiB";
+        }
+        buffer << " (" << residency.residentInputs() << " inputs resident)\n";
+
+        const auto &pages = PagePool::instance();
+        buffer << "Texture pages = " << pages.residentBytes() / MiB << " MiB";
+        if (pages.budget() != 0) {
+            buffer << " / " << pages.budget() / MiB << " MiB";
+        }
+        buffer << "\n";
+    }
     return buffer.str();
 }
 
@@ -269,43 +269,359 @@ void RenderingState::registerControls()
         RenderingState::instance().handleKey(key);
     });
     glutDisplayFunc([]() {
-        float time = getAnimationStep(std::chrono::seconds(5));
-        RenderingState::instance().render(time);
+        auto& scheduler = FrameScheduler::instance();
+        auto& profiler = FrameProfiler::instance();
+        Tracer::Span span("frame");
+        scheduler.beginFrame();
+        profiler.beginFrame();
+        {
+            FrameProfiler::Phase phase("update");
+            RenderingState::instance().update();
+        }
+        RenderingState::instance().render(scheduler.animationStep(std::chrono::seconds(5)));
+        profiler.endFrame();
+        scheduler.endFrame();
     });
-    glutIdleFunc([]() {
-        RenderingState::instance().idleFunc();
+    glutVisibilityFunc([](int state) {
+        FrameScheduler::instance().setVisible(state == GLUT_VISIBLE);
     });
     glutSpecialFunc([](int key, int, int) {
         RenderingState::instance().handleSpecialKey(key);
     });
-    glutMouseFunc([](int button, int state, int, int) {
+#ifdef FREEGLUT
+    glutCloseFunc([]() {
+        RenderingState::instance().glUnload();
+    });
+#endif
+    glutMouseFunc([](int button, int state, int x, int y) {
+        RenderingState::instance().registerInteraction();
         auto& options = RenderingState::instance().options;
         switch (button) {
             case GLUT_LEFT_BUTTON:
-                options.mouse_1_pressed = state == GLUT_DOWN;
-                break;
             case GLUT_RIGHT_BUTTON:
-                options.mouse_2_pressed = state == GLUT_DOWN;
+                // Shift turns the buttons into a brush, painting or erasing.
+                if (state == GLUT_DOWN && glutGetModifiers() == GLUT_ACTIVE_SHIFT) {
+                    options.painting = true;
+                    options.erasing = button == GLUT_RIGHT_BUTTON;
+                    RenderingState::instance().paintAt(x, y);
+                } else {
+                    options.painting = false;
+                    (button == GLUT_LEFT_BUTTON ? options.mouse_1_pressed : options.mouse_2_pressed) = state == GLUT_DOWN;
+                }
+                break;
+            case GLUT_MIDDLE_BUTTON:
+                if (state == GLUT_DOWN) {
+                    RenderingState::instance().pickAt(x, y);
+                }
                 break;
 
             default:
                 // Do nothing.
                 break;
         }
+        glutPostRedisplay();
     });
 }
 
 void RenderingState::handleMouseAt(int x, int y)
 {
+    if (options.painting) {
+        registerInteraction();
+        paintAt(x, y);
+        return;
+    }
+
     const float width = glutGet(GLUT_WINDOW_WIDTH) / 2.f;
     const float height = glutGet(GLUT_WINDOW_HEIGHT) / 2.f;
 
     angle[0] = (x - width) / width * 180;
     angle[1] = (y - height) / height * 90;
 
+    registerInteraction();
     glutPostRedisplay();
 }
 
+void RenderingState::pickAt(int x, int y)
+{
+    if (isLoading()) {
+        return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    if (!picker || pickerInput != currentInput) {
+        picker.emplace(currentData(), layerOrigins());
+        pickerInput = currentInput;
+    }
+
+    const auto [origin, direction] = cursorRay(x, y);
+    selection = picker->pick(origin, direction);
+    pickDuration = std::chrono::steady_clock::now() - start;
+    updateTopInputs();
+    glutPostRedisplay();
+}
+
+void RenderingState::paintAt(int x, int y)
+{
+    if (isLoading() || !options.editable) {
+        return;
+    }
+
+    const auto& input = currentData();
+    const auto layer = dynamic_cast<const InputLayerVisualisation*>(input.layers.front().first.get());
+    if (layer == nullptr) {
+        // Only image inputs can be painted on.
+        return;
+    }
+
+    auto [origin, direction] = cursorRay(x, y);
+    const auto layerOrigin = DrawList::layerOrigin(0, input.layers.size());
+    for (auto i : Range(3)) {
+        origin[i] -= layerOrigin[i];
+    }
+    const auto point = layer->imageCoordinates(origin, direction);
+    if (!point) {
+        return;
+    }
+
+    auto& request = edits[currentInput];
+    if (!request.base) {
+        auto positions = std::make_shared<std::vector<std::vector<float>>>();
+        for (auto& item : input.layers) {
+            positions->push_back(item.first->nodePositions());
+        }
+        request.input = currentInput;
+        request.generation = ++editSessions;
+        request.base = input.data;
+        request.positions = std::move(positions);
+    }
+
+    request.edits.push_back({(*point)[0], (*point)[1], BRUSH_RADIUS, options.erasing});
+    loader->perturb(request);
+}
+
+/**
+ * Undo all edits to the current input.
+ */
+void RenderingState::revertEdits()
+{
+    const auto request = edits.find(currentInput);
+    if (request == edits.end() || request->second.edits.empty()) {
+        return;
+    }
+
+    request->second.edits.clear();
+    loader->perturb(request->second);
+}
+
+/**
+ * Turn window coordinates into a ray through the scene, with the camera of the last frame.
+ *
+ * @return The origin and direction of the ray.
+ */
+std::pair<NodePicker::Vector, NodePicker::Vector> RenderingState::cursorRay(int x, int y) const
+{
+    GLdouble modelView[16], projection[16];
+    GLint viewport[4];
+    glPushMatrix();
+    configureRenderingContext();
+    glGetDoublev(GL_MODELVIEW_MATRIX, modelView);
+    glPopMatrix();
+    glGetDoublev(GL_PROJECTION_MATRIX, projection);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    std::array<GLdouble, 3> near, far;
+    const GLdouble windowY = viewport[3] - y;
+    gluUnProject(x, windowY, 0, modelView, projection, viewport, &near[0], &near[1], &near[2]);
+    gluUnProject(x, windowY, 1, modelView, projection, viewport, &far[0], &far[1], &far[2]);
+
+    NodePicker::Vector origin, direction;
+    for (auto i : Range(3)) {
+        origin[i] = near[i];
+        direction[i] = far[i] - near[i];
+    }
+
+    return {origin, direction};
+}
+
+/**
+ * @return The position of every layer's node coordinates, as rendered by renderScene().
+ */
+std::vector<NodePicker::Vector> RenderingState::layerOrigins() const
+{
+    const auto layers = currentData().layers.size();
+    std::vector<NodePicker::Vector> origins;
+    origins.reserve(layers);
+    for (auto i : Range(layers)) {
+        origins.push_back(DrawList::layerOrigin(i, layers));
+    }
+
+    return origins;
+}
+
+/**
+ * Describe the values of the currently selected node.
+ *
+ * The selection is kept when switching inputs, so this shows the values
+ * of the same node for the current input.
+ */
+std::string RenderingState::selectionInfo() const
+{
+    std::stringstream buffer;
+    const auto& layer = currentData().data->at(selection->layer);
+    const auto& shape = layer.shape();
+    buffer << "Selected: " << currentData().layers.at(selection->layer).first->displayName() << "\n";
+
+    if (shape.size() == 4) {
+        const auto channelSize = static_cast<std::size_t>(shape[2] * shape[3]);
+        if (selection->node >= static_cast<std::size_t>(shape[1])) {
+            return buffer.str();
+        }
+        const auto channel = layer.data() + selection->node * channelSize;
+        const auto [min, max] = std::minmax_element(channel, channel + channelSize);
+        const auto mean = std::accumulate(channel, channel + channelSize, 0.f) / channelSize;
+        const auto peak = std::distance(channel, max);
+
+        buffer << "Channel " << selection->node << " of " << shape[1]
+               << " (" << shape[2] << "x" << shape[3] << ")\n"
+               << "min = " << *min << ", mean = " << mean << ", max = " << *max
+               << " at (" << peak / shape[3] << ", " << peak % shape[3] << ")\n";
+    } else if (selection->node < layer.numEntries()) {
+        const auto value = layer[selection->node];
+        const auto rank = std::count_if(layer.begin(), layer.end(), [value](auto v) { return v > value; });
+        buffer << "Neuron " << selection->node << " of " << layer.numEntries() << "\n"
+               << "activation = " << value << " (rank " << rank + 1 << ")\n";
+    }
+
+    // The animation into a layer is kept with the layer before it.
+    if (selection->layer > 0 && currentData().layers.at(selection->layer - 1).second) {
+        const auto& [source, animation] = currentData().layers[selection->layer - 1];
+        const auto contributors = animation->strongestInputs(selection->node, TOP_CONTRIBUTORS);
+        if (!contributors.empty()) {
+            buffer << "Top contributors from " << source->displayName() << ":\n";
+            for (auto [strength, node] : contributors) {
+                buffer << "  " << strength << " from node " << node << "\n";
+            }
+        }
+    }
+
+    if (!topInputs.empty()) {
+        buffer << "Top inputs:\n";
+        for (auto& match : topInputs) {
+            buffer << "  " << match.score << " " << match.input << "\n";
+        }
+    }
+
+    if (options.showDebug) {
+        buffer << "Picked " << picker->size() << " nodes in "
+               << std::chrono::duration<float, std::micro>(pickDuration).count() << " us\n";
+    }
+
+    return buffer.str();
+}
+
+/**
+ * Decode images into a strip of square thumbnails, side by side.
+ *
+ * @return BGR pixels of the strip, bottom row first for glDrawPixels().
+ */
+static std::vector<unsigned char> decodeThumbnails(const std::vector<std::string>& paths, int size)
+{
+    cv::Mat strip(size, size * paths.size(), CV_8UC3, cv::Scalar(0, 0, 0));
+    for (auto i : Range(paths.size())) {
+        // Thumbnails are tiny, so let the decoder skip most of the work.
+        const auto image = cv::imread(paths[i], cv::IMREAD_REDUCED_COLOR_4);
+        if (image.empty()) {
+            LOG(WARNING) << "Failed to read " << paths[i];
+            continue;
+        }
+
+        const auto side = std::min(image.rows, image.cols);
+        const auto square = image(cv::Rect((image.cols - side) / 2, (image.rows - side) / 2, side, side));
+        auto tile = strip(cv::Rect(i * size, 0, size, size));
+        cv::resize(square, tile, cv::Size(size, size), 0, 0, cv::INTER_AREA);
+    }
+
+    cv::flip(strip, strip, 0);
+    return std::vector<unsigned char>(strip.data, strip.data + strip.total() * strip.elemSize());
+}
+
+/**
+ * Look up the inputs that activate the selected node the most, and start decoding their thumbnails.
+ */
+void RenderingState::updateTopInputs()
+{
+    // Any strip decoded so far is for an earlier selection.
+    std::size_t request;
+    {
+        std::lock_guard<std::mutex> lock(thumbnailMutex);
+        decodedThumbnails.reset();
+        request = ++thumbnailRequest;
+    }
+    topInputs.clear();
+    thumbnails.clear();
+    if (!activationIndex || !selection) {
+        return;
+    }
+
+    topInputs = activationIndex->lookup(currentData().data->at(selection->layer).name(), selection->node);
+    if (topInputs.empty()) {
+        return;
+    }
+
+    std::vector<std::string> paths;
+    std::transform(topInputs.begin(), topInputs.end(), std::back_inserter(paths),
+                   [](const auto& match) { return std::string(match.input); });
+
+    if (!thumbnailDecoder) {
+        thumbnailDecoder = std::make_unique<WorkQueue>(1);
+    }
+    thumbnailDecoder->submit([this, request, paths = std::move(paths)] {
+        if (request != thumbnailRequest) {
+            return;
+        }
+
+        Tracer::Span span("decode thumbnails");
+        auto strip = decodeThumbnails(paths, THUMBNAIL_SIZE);
+        std::lock_guard<std::mutex> lock(thumbnailMutex);
+        if (request == thumbnailRequest) {
+            decodedThumbnails = std::move(strip);
+            FrameScheduler::instance().notify();
+        }
+    });
+}
+
+/**
+ * Show the thumbnails of the top inputs, if the decoder has finished them.
+ *
+ * @return Whether the thumbnails of the latest selection are still being decoded.
+ */
+bool RenderingState::receiveThumbnails()
+{
+    if (topInputs.empty() || !thumbnails.empty()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(thumbnailMutex);
+    if (!decodedThumbnails) {
+        return true;
+    }
+
+    thumbnails = std::move(*decodedThumbnails);
+    decodedThumbnails.reset();
+    glutPostRedisplay();
+    return false;
+}
+
+void RenderingState::drawThumbnails() const
+{
+    if (thumbnails.empty()) {
+        return;
+    }
+
+    glWindowPos2i(2, 2);
+    glDrawPixels(THUMBNAIL_SIZE * topInputs.size(), THUMBNAIL_SIZE, GL_BGR, GL_UNSIGNED_BYTE, thumbnails.data());
+}
+
 void RenderingState::render(float time) const
 {
     // Clear Color and Depth Buffers
@@ -314,56 +630,86 @@ void RenderingState::render(float time) const
     if (!isLoading()) {
         renderVisualisation(time);
     } else {
-        renderLoadingScreen();
+        std::stringstream state;
+        state << "Loading input " << currentInput + 1 << "/" << visualisations.size() << "... ("
+              << loader->queued() << " queued)";
+        renderLoadingScreen(state.str());
     }
 
+    FrameProfiler::Phase phase("swap");
     glutSwapBuffers();
 }
 
 void RenderingState::renderVisualisation(float time) const
+{
+    renderScene(time);
+    renderOverlayText();
+}
+
+void RenderingState::renderScene(float time) const
 {
     configureRenderingContext();
+    PagePool::instance().beginFrame();
 
     glPushMatrix();
 
-    // Ensure we render back-to-front for transparency
-    if (angle[0] <= 0) {
+    {
+        FrameProfiler::Phase phase("scene");
+        drawCompiled(angle[0] > 0);
+
+        // Ensure we render back-to-front for transparency
+        if (angle[0] <= 0) {
             // Render from the first to the last layer.
-            glTranslatef(-LAYER_X_OFFSET / 2 * currentData->size(), 0, 0);
-            for (auto i : Range(currentData->size())) {
+            glTranslatef(-LAYER_X_OFFSET / 2 * currentData().layers.size(), 0, 0);
+            for (auto i : Range(currentData().layers.size())) {
                 drawLayer(time, i);
                 glTranslatef(LAYER_X_OFFSET, 0, 0);
             }
         } else {
             // Render from the last layer to the first layer.
-            glTranslatef(LAYER_X_OFFSET / 2 * (currentData->size() - 2), 0, 0);
-            for (auto i = currentData->size(); i--;) {
+            glTranslatef(LAYER_X_OFFSET / 2 * (currentData().layers.size() - 2), 0, 0);
+            for (auto i = currentData().layers.size(); i--;) {
                 drawLayer(time, i);
 
                 glTranslatef(-LAYER_X_OFFSET, 0, 0);
             }
         }
+    }
 
     glPopMatrix();
+}
 
-    renderOverlayText();
+void RenderingState::drawCompiled(bool reverse) const
+{
+    const auto& drawList = currentData().drawList;
+    FrameProfiler::Section section("draw list", "");
+
+    if (options.renderLayers) {
+        drawList.drawSurfaces(reverse, activationThreshold(), options.layerAlpha);
+    }
+    if (options.renderInteractionPaths) {
+        drawList.drawPaths(reverse, options.pathColor);
+    }
 }
 
 void RenderingState::drawLayer(float time, unsigned long i) const
 {
     glPushMatrix();
 
-    auto& layer = currentData->at(i);
+    auto& layer = currentData().layers.at(i);
+    const auto& drawList = currentData().drawList;
 
     layer.first->drawLayerName();
-    if (options.renderLayers) {
+    if (options.renderLayers && !drawList.coversLayer(i)) {
+        FrameProfiler::Section section(layer.first->displayName(), "");
         layer.first->draw(time);
     }
-    if (layer.second) {
+    if (layer.second && (options.renderInteractions || options.renderInteractionPaths)) {
+        FrameProfiler::Section section(layer.first->displayName(), " (interaction)");
         if (options.renderInteractions) {
             layer.second->draw(time);
         }
-        if (options.renderInteractionPaths) {
+        if (options.renderInteractionPaths && !drawList.coversPaths(i)) {
             layer.second->drawPaths();
         }
     }
@@ -373,9 +719,19 @@ void RenderingState::drawLayer(float time, unsigned long i) const
 
 void RenderingState::renderOverlayText() const
 {
+    FrameProfiler::Phase phase("overlay");
     std::stringstream overlayText;
     if (options.showDebug) {
-        overlayText << debugInfo() << "\n";
+        overlayText << debugInfo() << FrameProfiler::instance().report() << "\n";
+    }
+
+    if (isLoadingInBackground()) {
+        overlayText << "Loading inputs: " << loader->queued() << " queued, " << materialised << "/"
+                    << visualisations.size() << " built\n";
+    }
+
+    if (selection) {
+        overlayText << selectionInfo() << "\n";
     }
 
     if (options.showHelp) {
@@ -387,11 +743,20 @@ void RenderingState::renderOverlayText() const
                        "l: toggle layers visible\n"
                        "i: toggle interactions visible\n"
                        "o: toggle activated nodes only\n"
+                       "[/]: lower/raise activation threshold\n"
+                       ",/.: decrease/increase layer opacity\n"
+                       "</>: decrease/increase interaction opacity\n"
                        "p: toggle interaction paths visible\n"
                        "m: toggle movie mode\n"
+                       "space: pause animation\n"
                        "h: reset camera position\n"
+                       "middle click: inspect node\n"
+                       "shift+left/right drag: paint/erase input\n"
+                       "r: revert input edits\n"
                        "Right arrow: next input image\n"
                        "Left arrow: previous input image\n"
+                       "Page up/down: jump 10 input images\n"
+                       "Home/end: first/last input image\n"
                        "+/-: increase/decrease particle size\n"
                        "q: quit\n";
     }
@@ -400,65 +765,323 @@ void RenderingState::renderOverlayText() const
     setOrthographicProjection();
     glColor3f(1, 1, 0);
     renderText(overlayText.str(), 2, 10);
+    drawThumbnails();
+    if (options.showDebug) {
+        constexpr int graphWidth = 240, graphHeight = 80;
+        FrameProfiler::instance().drawGraph(glutGet(GLUT_WINDOW_WIDTH) - graphWidth - 10, 10, graphWidth, graphHeight);
+    }
     restorePerspectiveProjection();
 }
 
 void RenderingState::nextInput()
 {
-    ++currentData;
-    if (currentData == visualisations.end()) {
-        currentData = visualisations.begin();
+    jumpTo((currentInput + 1) % visualisations.size(), 1);
+    lastFrame = std::chrono::steady_clock::now();
+}
+
+void RenderingState::previousInput()
+{
+    jumpTo((currentInput + visualisations.size() - 1) % visualisations.size(), -1);
+}
+
+/**
+ * Make an input current.
+ *
+ * If the input is not built yet, it is requested before anything else.
+ *
+ * @param input Index of the input.
+ * @param direction The direction in which we're moving through the inputs.
+ */
+void RenderingState::jumpTo(std::size_t input, std::ptrdiff_t direction)
+{
+    currentInput = input;
+    direction_ = direction;
+    updateWindow();
+    updateResidency();
+}
+
+/**
+ * @return Whether the input is within the window around the current input.
+ */
+bool RenderingState::inWindow(std::size_t input) const
+{
+    if (inputWindow == 0) {
+        return true;
     }
 
-    lastFrame = std::chrono::steady_clock::now();
+    const auto size = visualisations.size();
+    const auto distance = (input + size - currentInput) % size;
+    return std::min(distance, size - distance) <= inputWindow;
 }
 
-void RenderingState::handleSpecialKey(int key)
+/**
+ * Drop inputs outside the window, and request the missing ones inside it.
+ *
+ * Inputs are requested in order of distance, in the current direction of
+ * travel first. Without a window, every input is requested that way.
+ */
+void RenderingState::updateWindow()
 {
-    if (isLoading()) {
-        // Don't handle user input while loading.
+    const auto size = static_cast<std::ptrdiff_t>(visualisations.size());
+    const auto reach = inputWindow == 0 ? size : std::min<std::ptrdiff_t>(inputWindow, size);
+    const auto neighbour = [=](std::ptrdiff_t offset) {
+        return static_cast<std::size_t>(((static_cast<std::ptrdiff_t>(currentInput) + offset) % size + size) % size);
+    };
+
+    for (auto i : Range(visualisations.size())) {
+        if (isMaterialised(i) && !inWindow(i)) {
+            dematerialise(i);
+        }
+    }
+
+    std::vector<std::size_t> wanted = {currentInput};
+    for (auto offset : Range<std::ptrdiff_t>(1, reach + 1)) {
+        wanted.push_back(neighbour(offset * direction_));
+    }
+    if (inputWindow != 0) {
+        for (auto offset : Range<std::ptrdiff_t>(1, reach + 1)) {
+            wanted.push_back(neighbour(-offset * direction_));
+        }
+    }
+
+    std::vector<std::size_t> missing;
+    for (auto input : wanted) {
+        if (!isMaterialised(input) && std::find(missing.begin(), missing.end(), input) == missing.end()) {
+            missing.push_back(input);
+        }
+    }
+
+    loader->schedule(missing);
+}
+
+bool RenderingState::isMaterialised(std::size_t input) const
+{
+    return visualisations[input].data != nullptr;
+}
+
+/**
+ * Destroy the visualisations of an input, releasing its memory.
+ *
+ * Must be called on the thread owning the GL context.
+ */
+void RenderingState::dematerialise(std::size_t input)
+{
+    residency.forget(input);
+    edits.erase(input);
+    auto& item = visualisations[input];
+    item.layers.clear();
+    item.data.reset();
+    --materialised;
+
+    if (picker && pickerInput == input) {
+        picker.reset();
+    }
+}
+
+/**
+ * Make sure the current input is on the GPU, and prefetch its neighbours.
+ *
+ * Inputs that are not built yet are skipped, this is called again when they arrive.
+ */
+void RenderingState::updateResidency()
+{
+    const auto size = static_cast<std::ptrdiff_t>(visualisations.size());
+    const auto current = static_cast<std::ptrdiff_t>(currentInput);
+    const auto neighbour = [=](std::ptrdiff_t offset) {
+        return static_cast<std::size_t>(((current + offset) % size + size) % size);
+    };
+
+    if (!isMaterialised(currentInput)) {
         return;
     }
+
+    residency.use(current);
+    // Prefetch the likely next input last, so it is the last to be evicted.
+    for (auto input : {neighbour(-direction_), neighbour(direction_)}) {
+        if (isMaterialised(input)) {
+            residency.prefetch(input);
+        }
+    }
+}
+
+void RenderingState::handleSpecialKey(int key)
+{
+    registerInteraction();
+    const auto inputs = visualisations.size();
     switch (key) {
         case GLUT_KEY_LEFT:
-            if (currentData == visualisations.begin()) {
-                currentData = visualisations.end();
-            }
-            --currentData;
+            previousInput();
             break;
 
         case GLUT_KEY_RIGHT:
             nextInput();
             break;
 
+        case GLUT_KEY_PAGE_DOWN:
+            jumpTo((currentInput + JUMP_DISTANCE) % inputs, 1);
+            break;
+
+        case GLUT_KEY_PAGE_UP:
+            jumpTo((currentInput + inputs - JUMP_DISTANCE % inputs) % inputs, -1);
+            break;
+
+        case GLUT_KEY_HOME:
+            jumpTo(0, 1);
+            break;
+
+        case GLUT_KEY_END:
+            jumpTo(inputs - 1, -1);
+            break;
+
         case GLUT_KEY_F1:
             toggle(options.showHelp);
-            glutPostRedisplay();
             break;
 
         case GLUT_KEY_F2:
             toggle(options.showDebug);
+            FrameProfiler::instance().setEnabled(options.showDebug);
             break;
 
         default:
             LOG(INFO) << "Received keystroke " << key;
     }
+
+    glutPostRedisplay();
 }
 
-bool RenderingState::renderActivatedOnly() const
+float RenderingState::activationThreshold() const
 {
-    return options.activatedOnly;
+    return options.activatedOnly ? options.activationThreshold : -1;
 }
 
 void RenderingState::loadOptions(const Options &programOptions)
+{
+    applyOptions(programOptions);
+
+    visualisations = VisualisationList(programOptions.inputs().size());
+    for (auto i : Range(visualisations.size())) {
+        visualisations[i].name = programOptions.inputs()[i];
+    }
+    residency.manage(visualisations);
+
+    if (!programOptions.indexPath().empty()) {
+        activationIndex.emplace(programOptions.indexPath());
+    }
+    // Statistics are not simulated, so there is nothing to perturb.
+    options.editable = !programOptions.statistic();
+
+    loader = std::make_unique<InputLoader>(programOptions, programOptions.activationCache());
+    jumpTo(0, 1);
+    FrameScheduler::instance().setBackgroundWork(true);
+}
+
+void RenderingState::setupOffscreen(const Options &programOptions, const OffscreenContext &context)
+{
+    applyOptions(programOptions);
+    std::copy_n(programOptions.cameraPosition().begin(), pos.size(), pos.begin());
+    std::copy_n(programOptions.cameraAngle().begin(), angle.size(), angle.begin());
+    changeWindowSize(context.width(), context.height());
+    setTextRendering(false);
+    // Every frame is rendered once, so it should be complete.
+    PagePool::instance().setUploadLimit(0);
+}
+
+void RenderingState::renderOffscreen(const Options &programOptions, const OffscreenContext &context)
+{
+    setupOffscreen(programOptions, context);
+
+    const auto& outputDir = programOptions.offscreenPath();
+    ensureDirectory(outputDir);
+
+    visualisations = VisualisationList(programOptions.inputs().size());
+    residency.manage(visualisations);
+
+    // Inputs are built in order, and each is dropped again after rendering.
+    loader = std::make_unique<InputLoader>(programOptions, 0);
+    std::vector<std::size_t> inputs(visualisations.size());
+    std::iota(inputs.begin(), inputs.end(), 0);
+    loader->schedule(inputs);
+
+    WorkQueue encoder(programOptions.encodeThreads());
+
+    for (auto remaining = visualisations.size(); remaining > 0; --remaining) {
+        auto result = loader->wait();
+
+        currentInput = result.first;
+        visualisations[currentInput] = std::move(result.second);
+        ++materialised;
+        residency.use(currentInput);
+
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        renderScene(programOptions.animationTime());
+
+        char path[PATH_MAX];
+        std::snprintf(path, sizeof(path), "%s/%05zu.png", outputDir.c_str(), currentInput);
+
+        encoder.submit([path = std::string(path), pixels = context.readPixels(), width = context.width(), height = context.height()]() mutable {
+            cv::Mat image(height, width, CV_8UC3, pixels.data());
+            cv::imwrite(path, image);
+        });
+
+        dematerialise(currentInput);
+    }
+
+    encoder.wait();
+    loader.reset();
+    glUnload();
+    LOG(INFO) << "Rendered " << visualisations.size() << " images to " << outputDir;
+}
+
+std::pair<std::chrono::steady_clock::duration, std::chrono::steady_clock::duration>
+RenderingState::renderOnce(const Options &programOptions, const OffscreenContext &context, InputVisualisation &&input)
+{
+    using clock = std::chrono::steady_clock;
+
+    setupOffscreen(programOptions, context);
+    visualisations = VisualisationList(1);
+    residency.manage(visualisations);
+    currentInput = 0;
+    visualisations[currentInput] = std::move(input);
+    ++materialised;
+
+    const auto start = clock::now();
+    residency.use(currentInput);
+    glFinish();
+    const auto uploaded = clock::now();
+
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    renderScene(programOptions.animationTime());
+    glFinish();
+    const auto rendered = clock::now();
+
+    dematerialise(currentInput);
+
+    return {uploaded - start, rendered - uploaded};
+}
+
+void RenderingState::glUnload()
+{
+    unloadImageTileArray();
+    Colormap::instance().glUnload();
+    PagePool::instance().clear();
+}
+
+void RenderingState::applyOptions(const Options &programOptions)
 {
     options.pathColor = programOptions.pathColor();
     options.layerAlpha = programOptions.layerTransparency();
     options.interactionAlpha = programOptions.interactionTransparency();
+    options.activationThreshold = programOptions.activationThreshold();
     options.brainMode = programOptions.brainMode();
     frameTime = std::chrono::milliseconds(programOptions.inputMillis());
-
-    loadingFuture = std::async(std::launch::async, loadVisualisations, programOptions);
+    idleTimeout = std::chrono::seconds(programOptions.idleTimeout());
+    inputWindow = programOptions.inputWindow();
+    residency.setBudget(programOptions.vramBudget());
+    PagePool::instance().setBudget(programOptions.textureBudget());
+    Colormap::instance().setColors(NEGATIVE_COLOR, NEUTRAL_COLOR, POSITIVE_COLOR);
+
+    const auto& background = programOptions.backgroundColor();
+    glClearColor(background[0], background[1], background[2], background[3]);
 }
 
 const Color &RenderingState::pathColor() const
@@ -466,7 +1089,13 @@ const Color &RenderingState::pathColor() const
     return options.pathColor;
 }
 
-RenderingState::RenderingState() noexcept
+RenderingState::RenderingState() noexcept :
+    currentInput(0),
+    direction_(1),
+    inputWindow(0),
+    materialised(0),
+    editSessions(0),
+    thumbnailRequest(0)
 {
     // Enable depth test to fix objects behind you
     glEnable(GL_DEPTH_TEST);
@@ -495,69 +1124,111 @@ float RenderingState::layerAlpha() const
     return options.layerAlpha;
 }
 
-/**
- * Attempt to wait for completion of a future, for less than a frame.
- *
- * @tparam T
- * @param f The future to wait for
- * @return The result of the computation, or an empty optional if it hasn't finished.
- */
-template<class T>
-static std::optional<T> awaitCompletion(std::future<T>& f)
+void RenderingState::update()
 {
-    constexpr auto waitTime = std::chrono::milliseconds(10);
-    switch (f.wait_for(waitTime)) {
-        case std::future_status::timeout:
-            return std::nullopt;
-
-        case std::future_status::ready:
-            return f.get();
+    using namespace std::chrono;
+    auto& scheduler = FrameScheduler::instance();
 
-        default:
-            LOG(ERROR) << "loading status was deferred, invalid state!";
-            abort();
-    }
-}
+    receiveInputs();
+    const bool decoding = receiveThumbnails();
+    scheduler.setBackgroundWork(isLoadingInBackground() || decoding);
 
-
-void RenderingState::idleFunc()
-{
-    if (isLoading()) {
-        if (auto result = awaitCompletion(loadingFuture); result) {
-            visualisations = std::move(*result);
-            loadGLItems();
-            currentData = visualisations.begin();
-        }
-    } else {
+    if (!isLoading()) {
         if (options.mouse_1_pressed) {
             move('w', false);
         }
         if (options.mouse_2_pressed) {
             move('s', false);
         }
-        if (options.videoMode && std::chrono::steady_clock::now() - lastFrame > frameTime) {
-            nextInput();
+        if (options.videoMode) {
+            if (steady_clock::now() - lastFrame > frameTime) {
+                nextInput();
+            }
+            scheduler.wakeAfter(frameTime - (steady_clock::now() - lastFrame));
         }
-        throttleIdleFunc();
     }
-    glutPostRedisplay();
+
+    const bool moving = options.mouse_1_pressed || options.mouse_2_pressed;
+    const bool animated = !scheduler.paused() && options.renderInteractions && !isIdle();
+    scheduler.setAnimating(isLoading() || moving || animated);
 }
 
-void RenderingState::loadGLItems()
+/**
+ * Collect any inputs finished by the loader thread.
+ *
+ * Inputs become visible as soon as they arrive. Inputs that left the
+ * window while they were being built are dropped again.
+ */
+void RenderingState::receiveInputs()
 {
-    for (auto &item : visualisations) {
-        for (auto &item2 : item) {
-            item2.first->glLoad();
-            if (item2.second) {
-                item2.second->glLoad();
-            }
+    if (!loader) {
+        return;
+    }
+
+    Tracer::Span span("receive inputs");
+    bool received = false;
+    while (auto result = loader->poll()) {
+        if (!inWindow(result->first) || isMaterialised(result->first)) {
+            continue;
         }
+
+        visualisations[result->first] = std::move(result->second);
+        ++materialised;
+        received = true;
+    }
+
+    while (auto update = loader->pollUpdate()) {
+        // Updates for inputs dropped since are of no use.
+        if (!isMaterialised(update->first) || edits.count(update->first) == 0) {
+            continue;
+        }
+
+        residency.replace(update->first, std::move(update->second));
+        glutPostRedisplay();
+    }
+
+    if (received) {
+        updateResidency();
+        glutPostRedisplay();
     }
 }
 
+/**
+ * @return Whether the current input is still being built.
+ */
 bool RenderingState::isLoading() const
 {
-    return loadingFuture.valid();
+    return !isMaterialised(currentInput);
+}
+
+/**
+ * @return Whether inputs are being built in the background.
+ */
+bool RenderingState::isLoadingInBackground() const
+{
+    return loader && loader->queued() > 0;
+}
+
+const InputVisualisation &RenderingState::currentData() const
+{
+    return visualisations.at(currentInput);
+}
+
+void RenderingState::registerInteraction()
+{
+    lastInteraction = std::chrono::steady_clock::now();
+}
+
+/**
+ * @return Whether the user has not touched the viewer for a while.
+ */
+bool RenderingState::isIdle() const
+{
+    if (idleTimeout.count() == 0 || options.videoMode) {
+        return false;
+    }
+
+    return std::chrono::steady_clock::now() - lastInteraction > idleTimeout;
 }
 
 bool RenderingState::brainMode()
@@ -1,12 +1,23 @@
 #pragma once
 
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <optional>
 #include <string>
-#include <future>
+#include <memory>
 #include "LayerInfo.hpp"
 #include "LayerData.hpp"
 #include "LayerVisualisation.hpp"
 #include "Animation.hpp"
 #include "Options.hpp"
+#include "ResidencyManager.hpp"
+#include "visualisations.hpp"
+#include "OffscreenContext.hpp"
+#include "NodePicker.hpp"
+#include "ActivationIndex.hpp"
+#include "InputLoader.hpp"
+#include "WorkQueue.hpp"
 
 namespace fmri
 {
@@ -28,6 +39,25 @@ namespace fmri
          * @param y coordinate
          */
         void handleMouseAt(int x, int y);
+        /**
+         * Select the node under the given window coordinates.
+         *
+         * The selected node's values are shown in the overlay.
+         *
+         * @param x coordinate
+         * @param y coordinate
+         */
+        void pickAt(int x, int y);
+        /**
+         * Paint over the input image under the given window coordinates.
+         *
+         * The network is simulated again with the edits in the
+         * background, and the changed layers are swapped in when done.
+         *
+         * @param x coordinate
+         * @param y coordinate
+         */
+        void paintAt(int x, int y);
         /**
          * GLUT keyboard handler function
          * @param x
@@ -38,6 +68,13 @@ namespace fmri
          * @param key
          */
         void handleSpecialKey(int key);
+        /**
+         * Update the state for a new frame.
+         *
+         * Handles finished loading, continuous movement and movie mode,
+         * and tells the FrameScheduler whether the scene is animating.
+         */
+        void update();
         void render(float time) const;
 
         /**
@@ -46,10 +83,41 @@ namespace fmri
          * @param programOptions
          */
         void loadOptions(const Options& programOptions);
+
+        /**
+         * Render every input to an image file, without a window.
+         *
+         * All inputs are loaded synchronously, and then rendered one by
+         * one from the configured camera pose into the framebuffer of the
+         * given context. Encoding the images happens in the background.
+         *
+         * @param programOptions
+         * @param context Active offscreen context to render with.
+         */
+        void renderOffscreen(const Options& programOptions, const OffscreenContext& context);
+        /**
+         * Upload a single input and render one frame of it offscreen.
+         *
+         * Waits for the GPU to finish each step, so the steps can be
+         * timed. The input is dropped again afterwards.
+         *
+         * @param programOptions
+         * @param context Active offscreen context to render with.
+         * @param input Visualisations to render.
+         * @return Time taken by the upload, and by rendering the frame.
+         */
+        std::pair<std::chrono::steady_clock::duration, std::chrono::steady_clock::duration>
+        renderOnce(const Options& programOptions, const OffscreenContext& context, InputVisualisation&& input);
+        /**
+         * Release the GL resources shared between inputs.
+         *
+         * Call this while the context is still current, before it is destroyed.
+         */
+        void glUnload();
         /**
-         * @return Whether the network should only render activated nodes, rather than all of them.
+         * @return Relative activation nodes need to be drawn, negative if all nodes should be drawn.
          */
-        bool renderActivatedOnly() const;
+        float activationThreshold() const;
 
         const Color& pathColor() const;
         float interactionAlpha() const;
@@ -66,23 +134,52 @@ namespace fmri
             bool renderInteractions = true;
             bool activatedOnly = false;
             bool renderInteractionPaths = false;
+            float activationThreshold;
             float layerAlpha;
             float interactionAlpha;
             Color pathColor;
             bool mouse_1_pressed = false;
             bool mouse_2_pressed = false;
+            bool painting = false;
+            bool erasing = false;
+            bool editable = false;
             bool brainMode;
             bool videoMode = false;
         } options;
         std::array<float, 3> pos;
         std::array<float, 2> angle;
-        std::vector<std::vector<std::pair<std::unique_ptr<LayerVisualisation>, std::unique_ptr<Animation>>>> visualisations;
-        std::future<decltype(visualisations)> loadingFuture;
+        VisualisationList visualisations;
+        std::unique_ptr<InputLoader> loader;
+        ResidencyManager residency;
         std::chrono::milliseconds frameTime;
         std::chrono::steady_clock::time_point lastFrame;
-
-        decltype(visualisations)::iterator currentData;
-
+        std::chrono::seconds idleTimeout;
+        std::chrono::steady_clock::time_point lastInteraction;
+
+        std::size_t currentInput;
+        std::ptrdiff_t direction_;
+        std::size_t inputWindow;
+        std::size_t materialised;
+
+        std::optional<NodePicker> picker;
+        std::size_t pickerInput;
+        std::optional<NodePicker::Hit> selection;
+        std::chrono::steady_clock::duration pickDuration;
+
+        // Edits painted over every input, kept until the input is dropped.
+        std::map<std::size_t, InputLoader::Perturbation> edits;
+        std::size_t editSessions;
+
+        std::optional<ActivationIndex> activationIndex;
+        // Top inputs of the selected node, and their thumbnails side by side once decoded.
+        std::vector<ActivationIndex::Match> topInputs;
+        std::vector<unsigned char> thumbnails;
+        // Thumbnails are decoded on a worker, only the strip for the latest request is kept.
+        std::mutex thumbnailMutex;
+        std::atomic<std::size_t> thumbnailRequest;
+        std::optional<std::vector<unsigned char>> decodedThumbnails;
+        // Declared last, so its jobs finish before the state they use is gone.
+        std::unique_ptr<WorkQueue> thumbnailDecoder;
 
         RenderingState() noexcept;
 
@@ -90,19 +187,55 @@ namespace fmri
 
         void move(unsigned char key, bool sprint);
 
-        void idleFunc();
+        void registerInteraction();
+        bool isIdle() const;
 
         std::string debugInfo() const;
+        std::string selectionInfo() const;
+        void updateTopInputs();
+        bool receiveThumbnails();
+        void drawThumbnails() const;
+        std::vector<NodePicker::Vector> layerOrigins() const;
+        std::pair<NodePicker::Vector, NodePicker::Vector> cursorRay(int x, int y) const;
+        void revertEdits();
         void renderOverlayText() const;
 
         void drawLayer(float time, unsigned long i) const;
+        /**
+         * Draw the compiled geometry of all layers of the current input.
+         *
+         * @param reverse Draw from the last layer to the first.
+         */
+        void drawCompiled(bool reverse) const;
 
         void renderVisualisation(float time) const;
+        void renderScene(float time) const;
 
-        void loadGLItems();
+        void applyOptions(const Options& programOptions);
+        void setupOffscreen(const Options& programOptions, const OffscreenContext& context);
+
+        void receiveInputs();
 
         bool isLoading() const;
+        bool isLoadingInBackground() const;
+        const InputVisualisation& currentData() const;
+
+        static constexpr std::size_t JUMP_DISTANCE = 10;
+        static constexpr int THUMBNAIL_SIZE = 64;
+        static constexpr std::size_t TOP_CONTRIBUTORS = 5;
+        // Relative to the input width.
+        static constexpr float BRUSH_RADIUS = 0.04f;
+        static constexpr float THRESHOLD_STEP = 0.05f;
+        static constexpr float OPACITY_STEP = 0.1f;
 
         void nextInput();
+        void previousInput();
+        void jumpTo(std::size_t input, std::ptrdiff_t direction);
+        void updateResidency();
+
+        bool inWindow(std::size_t input) const;
+        void updateWindow();
+        bool isMaterialised(std::size_t input) const;
+        void dematerialise(std::size_t input);
     };
 }
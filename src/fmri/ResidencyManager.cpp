@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <glog/logging.h>
+#include "ResidencyManager.hpp"
+#include "Tracer.hpp"
+
+using namespace fmri;
+
+ResidencyManager::ResidencyManager(std::size_t budget) noexcept :
+        visualisations(nullptr),
+        budget_(budget),
+        residentBytes_(0)
+{
+}
+
+void ResidencyManager::manage(VisualisationList &visualisations)
+{
+    this->visualisations = &visualisations;
+    lru.clear();
+    residentBytes_ = 0;
+}
+
+void ResidencyManager::use(std::size_t input)
+{
+    if (auto it = find(input); it != lru.end()) {
+        lru.splice(lru.begin(), lru, it);
+    } else {
+        load(input, lru.begin());
+    }
+
+    evict(1);
+    LOG_IF(WARNING, !fitsInBudget(0)) << "Input " << input << " exceeds the GPU memory budget by itself.";
+}
+
+void ResidencyManager::prefetch(std::size_t input)
+{
+    if (lru.empty()) {
+        use(input);
+        return;
+    }
+
+    auto it = find(input);
+    auto position = std::next(lru.begin());
+
+    if (it == lru.begin()) {
+        // Already the most recently used input.
+        return;
+    } else if (it != lru.end()) {
+        lru.splice(position, lru, it);
+    } else if (lru.front().bytes + estimateUsage(input) <= budget_ || budget_ == 0) {
+        load(input, position);
+    } else {
+        // Would only evict the current input, skip it.
+        return;
+    }
+
+    evict(2);
+}
+
+void ResidencyManager::forget(std::size_t input)
+{
+    if (auto it = find(input); it != lru.end()) {
+        residentBytes_ -= it->bytes;
+        lru.erase(it);
+    }
+}
+
+void ResidencyManager::replace(std::size_t input, VisualisationUpdate &&update)
+{
+    CHECK(visualisations != nullptr) << "No visualisations to manage";
+    auto &visualisation = visualisations->at(input);
+    const auto entry = find(input);
+    const bool resident = entry != lru.end();
+
+    Tracer::Span span("replace layers");
+    for (auto &[i, layer] : update.layers) {
+        auto &current = visualisation.layers.at(i).first;
+        if (resident) {
+            layer->glReplace(*current);
+        }
+        // Costs are only measured when an input is first simulated.
+        layer->copyAnnotation(*current);
+        current = std::move(layer);
+    }
+    for (auto &[i, animation] : update.animations) {
+        auto &current = visualisation.layers.at(i).second;
+        if (resident && animation) {
+            if (current) {
+                animation->glReplace(*current);
+            } else {
+                animation->glLoad();
+            }
+        }
+        current = std::move(animation);
+    }
+    visualisation.data = std::move(update.data);
+
+    if (resident) {
+        visualisation.drawList.glLoad(visualisation);
+        residentBytes_ -= entry->bytes;
+        entry->bytes = estimateUsage(input);
+        residentBytes_ += entry->bytes;
+    }
+}
+
+void ResidencyManager::setBudget(std::size_t budget)
+{
+    budget_ = budget;
+    evict(1);
+}
+
+std::size_t ResidencyManager::budget() const
+{
+    return budget_;
+}
+
+std::size_t ResidencyManager::residentBytes() const
+{
+    return residentBytes_;
+}
+
+std::size_t ResidencyManager::residentInputs() const
+{
+    return lru.size();
+}
+
+std::list<ResidencyManager::Entry>::iterator ResidencyManager::find(std::size_t input)
+{
+    return std::find_if(lru.begin(), lru.end(), [input](const Entry& e) { return e.input == input; });
+}
+
+void ResidencyManager::load(std::size_t input, std::list<Entry>::iterator position)
+{
+    CHECK(visualisations != nullptr) << "No visualisations to manage";
+    std::size_t bytes = 0;
+
+    auto &visualisation = visualisations->at(input);
+    Tracer::setInput(visualisation.name);
+    Tracer::Span span("upload");
+    for (auto &item : visualisation.layers) {
+        Tracer::Span layerSpan("upload layer", item.first->displayName());
+        item.first->glLoad();
+        bytes += item.first->glMemoryUsage();
+        if (item.second) {
+            item.second->glLoad();
+            bytes += item.second->glMemoryUsage();
+        }
+    }
+
+    {
+        Tracer::Span compileSpan("compile draw list");
+        visualisation.drawList.glLoad(visualisation);
+        bytes += visualisation.drawList.glMemoryUsage();
+    }
+
+    lru.insert(position, {input, bytes});
+    residentBytes_ += bytes;
+}
+
+void ResidencyManager::evict(std::size_t protect)
+{
+    while (!fitsInBudget(0) && lru.size() > protect) {
+        const auto entry = lru.back();
+        lru.pop_back();
+
+        auto &visualisation = visualisations->at(entry.input);
+        for (auto &item : visualisation.layers) {
+            item.first->glUnload();
+            if (item.second) {
+                item.second->glUnload();
+            }
+        }
+        visualisation.drawList.glUnload();
+
+        residentBytes_ -= entry.bytes;
+    }
+}
+
+std::size_t ResidencyManager::estimateUsage(std::size_t input) const
+{
+    auto &visualisation = visualisations->at(input);
+    // Only known once the draw list has been compiled before.
+    std::size_t bytes = visualisation.drawList.glMemoryUsage();
+    for (auto &item : visualisation.layers) {
+        bytes += item.first->glMemoryUsage();
+        if (item.second) {
+            bytes += item.second->glMemoryUsage();
+        }
+    }
+
+    return bytes;
+}
+
+bool ResidencyManager::fitsInBudget(std::size_t bytes) const
+{
+    return budget_ == 0 || residentBytes_ + bytes <= budget_;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include "visualisations.hpp"
+
+namespace fmri
+{
+    /**
+     * Manager for the GPU resources of all loaded inputs.
+     *
+     * Only the inputs that are actually needed are uploaded. When the
+     * estimated memory usage exceeds the budget, the least recently used
+     * inputs are unloaded again. Drawables keep their CPU-side data, so
+     * an unloaded input can be uploaded again later.
+     *
+     * All methods should be called from the thread owning the GL context.
+     */
+    class ResidencyManager
+    {
+    public:
+        /**
+         * @param budget Memory budget in bytes. 0 means unlimited.
+         */
+        explicit ResidencyManager(std::size_t budget = 0) noexcept;
+
+        /**
+         * Start managing a new set of visualisations.
+         *
+         * Any previously managed visualisations are forgotten, but not unloaded.
+         *
+         * @param visualisations
+         */
+        void manage(VisualisationList& visualisations);
+
+        /**
+         * Ensure an input is loaded and mark it as most recently used.
+         *
+         * The input being used is never evicted, even if it does not fit
+         * in the budget by itself.
+         *
+         * @param input Index of the input.
+         */
+        void use(std::size_t input);
+
+        /**
+         * Load an input in anticipation of future use.
+         *
+         * The input is only loaded if it fits in the budget together with
+         * the most recently used input. It is considered more recent than
+         * anything other than that input.
+         *
+         * @param input Index of the input.
+         */
+        void prefetch(std::size_t input);
+
+        /**
+         * Stop tracking an input whose drawables are about to be destroyed.
+         *
+         * Destroying the drawables releases their GPU resources, so
+         * nothing is unloaded explicitly.
+         *
+         * @param input Index of the input.
+         */
+        void forget(std::size_t input);
+
+        /**
+         * Replace the changed visualisations of an input.
+         *
+         * If the input is resident, the replacements are uploaded over
+         * the GPU resources of the drawables they replace, and the draw
+         * list is recompiled into its existing buffers.
+         *
+         * @param input Index of the input.
+         * @param update Replacements for the input, consumed.
+         */
+        void replace(std::size_t input, VisualisationUpdate&& update);
+
+        void setBudget(std::size_t budget);
+        std::size_t budget() const;
+        std::size_t residentBytes() const;
+        std::size_t residentInputs() const;
+
+    private:
+        struct Entry
+        {
+            std::size_t input;
+            std::size_t bytes;
+        };
+
+        VisualisationList* visualisations;
+        std::size_t budget_;
+        std::size_t residentBytes_;
+        // Resident inputs, most recently used first.
+        std::list<Entry> lru;
+
+        std::list<Entry>::iterator find(std::size_t input);
+
+        void load(std::size_t input, std::list<Entry>::iterator position);
+        void evict(std::size_t protect);
+
+        std::size_t estimateUsage(std::size_t input) const;
+        bool fitsInBudget(std::size_t bytes) const;
+    };
+}
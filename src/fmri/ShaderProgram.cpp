@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <glog/logging.h>
+#include "ShaderProgram.hpp"
+
+using namespace fmri;
+
+static GLuint compileShader(GLenum type, std::string_view source)
+{
+    const auto shader = glCreateShader(type);
+    CHECK_NE(shader, 0) << "Failed to allocate a shader.";
+
+    const GLchar *sources[] = {source.data()};
+    const GLint lengths[] = {static_cast<GLint>(source.size())};
+    glShaderSource(shader, 1, sources, lengths);
+    glCompileShader(shader);
+
+    GLint status;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status != GL_TRUE) {
+        GLint length;
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+        std::string log(std::max(length, 1), '\0');
+        glGetShaderInfoLog(shader, length, nullptr, log.data());
+        LOG(FATAL) << "Failed to compile shader: " << log;
+    }
+
+    return shader;
+}
+
+ShaderProgram::ShaderProgram() noexcept :
+    id(0)
+{
+}
+
+ShaderProgram::ShaderProgram(std::string_view vertexSource, std::string_view fragmentSource) :
+    id(glCreateProgram())
+{
+    CHECK_NE(id, 0) << "Failed to allocate a shader program.";
+
+    const auto vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+    const auto fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+    glAttachShader(id, vertexShader);
+    glAttachShader(id, fragmentShader);
+    glLinkProgram(id);
+
+    // The program keeps the shaders alive for as long as it needs them.
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    GLint status;
+    glGetProgramiv(id, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        GLint length;
+        glGetProgramiv(id, GL_INFO_LOG_LENGTH, &length);
+        std::string log(std::max(length, 1), '\0');
+        glGetProgramInfoLog(id, length, nullptr, log.data());
+        LOG(FATAL) << "Failed to link shader program: " << log;
+    }
+}
+
+ShaderProgram::ShaderProgram(ShaderProgram &&other) noexcept :
+    id(std::exchange(other.id, 0))
+{
+}
+
+ShaderProgram::~ShaderProgram()
+{
+    if (id != 0) {
+        glDeleteProgram(id);
+    }
+}
+
+ShaderProgram &ShaderProgram::operator=(ShaderProgram &&other) noexcept
+{
+    std::swap(id, other.id);
+    return *this;
+}
+
+void ShaderProgram::use() const
+{
+    CHECK_NE(id, 0) << "Shader program doesn't hold a reference!";
+    glUseProgram(id);
+}
+
+GLint ShaderProgram::uniform(const char *name) const
+{
+    return glGetUniformLocation(id, name);
+}
+
+ShaderProgram::operator bool() const
+{
+    return id != 0;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string_view>
+#include <GL/gl.h>
+
+namespace fmri
+{
+    /**
+     * Linked GLSL program with RAII semantics.
+     *
+     * Like Texture, instances can only be moved. Compilation and link
+     * errors are fatal, since the shaders are part of the program.
+     */
+    class ShaderProgram
+    {
+    public:
+        ShaderProgram() noexcept;
+        ShaderProgram(std::string_view vertexSource, std::string_view fragmentSource);
+        ShaderProgram(ShaderProgram &&) noexcept;
+        ShaderProgram(const ShaderProgram &) = delete;
+
+        ~ShaderProgram();
+
+        ShaderProgram &operator=(ShaderProgram &&) noexcept;
+        ShaderProgram &operator=(const ShaderProgram &) = delete;
+
+        /**
+         * Make this the current program.
+         */
+        void use() const;
+        /**
+         * Look up a uniform location.
+         *
+         * @param name Name of the uniform in the source.
+         * @return The location, or -1 if the uniform is not active.
+         */
+        GLint uniform(const char *name) const;
+
+        explicit operator bool() const;
+
+    private:
+        GLuint id;
+    };
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <optional>
@@ -10,6 +11,7 @@
 
 #include "Simulator.hpp"
 #include "Range.hpp"
+#include "Tracer.hpp"
 
 using namespace caffe;
 using namespace std;
@@ -25,9 +27,17 @@ struct Simulator::Impl
 
     Impl(const string& model_file, const string& weights_file, const string& means_file);
 
+    // Input kept for perturbation, before mean subtraction.
+    string perturbedFile;
+    cv::Mat perturbedInput;
+
     vector<cv::Mat> getWrappedInputLayer();
     cv::Mat preprocess(cv::Mat original) const;
-    vector<LayerData> simulate(const string &input_file);
+    cv::Mat readInput(const string &input_file) const;
+    void fillInputLayer(const cv::Mat &sample);
+    vector<LayerData> simulate(const string &input_file, vector<chrono::steady_clock::duration> *layerTimes);
+    vector<LayerData> perturb(const string &input_file, const vector<Brush> &edits);
+    vector<LayerData> forward(vector<chrono::steady_clock::duration> *layerTimes);
     const map<string, LayerInfo>& layerInfo() const;
 
     void computeLayerInfo();
@@ -45,7 +55,17 @@ Simulator::Simulator(const string& model_file, const string& weights_file, const
 
 vector<LayerData> Simulator::simulate(const string& image_file)
 {
-    return pImpl->simulate(image_file);
+    return pImpl->simulate(image_file, nullptr);
+}
+
+vector<LayerData> Simulator::simulate(const string &input_file, vector<chrono::steady_clock::duration> &layerTimes)
+{
+    return pImpl->simulate(input_file, &layerTimes);
+}
+
+vector<LayerData> Simulator::perturb(const string &input_file, const vector<Brush> &edits)
+{
+    return pImpl->perturb(input_file, edits);
 }
 
 Simulator::Impl::Impl(const string& model_file, const string& weights_file, const string& means_file) :
@@ -94,19 +114,83 @@ void Simulator::Impl::loadMeans(const string &means_file)
     this->means = cv::Mat(input_geometry, mean.type(), cv::mean(mean));
 }
 
-vector<LayerData> Simulator::Impl::simulate(const string& image_file)
+vector<LayerData> Simulator::Impl::simulate(const string& image_file, vector<chrono::steady_clock::duration> *layerTimes)
+{
+    fillInputLayer(readInput(image_file));
+
+    return forward(layerTimes);
+}
+
+vector<LayerData> Simulator::Impl::perturb(const string &input_file, const vector<Brush> &edits)
+{
+    if (input_file != perturbedFile) {
+        perturbedInput = readInput(input_file);
+        perturbedFile = input_file;
+    }
+
+    {
+        Tracer::Span span("paint");
+        auto edited = perturbedInput.clone();
+        const auto erased = means ? cv::mean(*means) : cv::Scalar::all(0);
+        for (auto &brush : edits) {
+            const cv::Point center(static_cast<int>(brush.x * edited.cols), static_cast<int>(brush.y * edited.rows));
+            const auto radius = std::max(1, static_cast<int>(brush.radius * edited.cols));
+            cv::circle(edited, center, radius, brush.erase ? erased : cv::Scalar::all(255), cv::FILLED);
+        }
+
+        fillInputLayer(edited);
+    }
+
+    return forward(nullptr);
+}
+
+/**
+ * Read and preprocess an input, without subtracting the means.
+ */
+cv::Mat Simulator::Impl::readInput(const string &input_file) const
 {
-	cv::Mat im = cv::imread(image_file, -1);
+	cv::Mat im;
+	{
+		Tracer::Span span("imread");
+		im = cv::imread(input_file, -1);
+	}
 
     assert(!im.empty());
 
-    auto input = preprocess(im);
+    Tracer::Span span("preprocess");
+    return preprocess(im);
+}
+
+void Simulator::Impl::fillInputLayer(const cv::Mat &sample)
+{
     auto channels = getWrappedInputLayer();
+    if (!means) {
+        cv::split(sample, channels);
+        return;
+    }
 
-    cv::split(input, channels);
+    cv::Mat normalized;
+    cv::subtract(sample, *means, normalized);
+    cv::split(normalized, channels);
+}
 
-    net.Forward();
+vector<LayerData> Simulator::Impl::forward(vector<chrono::steady_clock::duration> *layerTimes)
+{
+    {
+        Tracer::Span span("forward");
+        if (layerTimes == nullptr) {
+            net.Forward();
+        } else {
+            layerTimes->clear();
+            for (auto i : Range(static_cast<int>(net.layers().size()))) {
+                const auto start = chrono::steady_clock::now();
+                net.ForwardFromTo(i, i);
+                layerTimes->push_back(chrono::steady_clock::now() - start);
+            }
+        }
+    }
 
+	Tracer::Span span("copy layers");
 	vector<LayerData> result;
 
 	const auto& names = net.layer_names();
@@ -180,15 +264,7 @@ cv::Mat Simulator::Impl::preprocess(cv::Mat original) const
     cv::Mat sample_float;
     resized.convertTo(sample_float, num_channels == 3 ? CV_32FC3 : CV_32FC1);
 
-    if (!means) {
-        return sample_float;
-    }
-
-    cv::Mat normalized;
-    cv::subtract(sample_float, *means, normalized);
-
-    return normalized;
-
+    return sample_float;
 }
 
 const map<string, LayerInfo> &Simulator::Impl::layerInfo() const
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <string>
 #include <memory>
 #include <vector>
@@ -13,10 +14,43 @@ namespace fmri {
 
     class Simulator {
     public:
+        /**
+         * A round patch painted over the input.
+         *
+         * Coordinates are relative to the input size, so (0, 0) is the
+         * top left and (1, 1) the bottom right corner.
+         */
+        struct Brush
+        {
+            float x;
+            float y;
+            // Relative to the input width.
+            float radius;
+            // Reset to the mean instead of painting white.
+            bool erase;
+        };
+
         Simulator(const string &model_file, const string &weights_file, const string &means_file = "");
         ~Simulator();
 
         vector<LayerData> simulate(const string &input_file);
+        /**
+         * Simulate an input, running and timing every layer separately.
+         *
+         * @param input_file
+         * @param layerTimes Filled with the forward time of every layer, in network order.
+         */
+        vector<LayerData> simulate(const string &input_file, vector<std::chrono::steady_clock::duration> &layerTimes);
+        /**
+         * Simulate an input with edits painted over it.
+         *
+         * The preprocessed input is kept between calls, so repeated edits
+         * of the same input only repeat the forward pass.
+         *
+         * @param input_file
+         * @param edits Patches to paint, in order. May be empty.
+         */
+        vector<LayerData> perturb(const string &input_file, const vector<Brush> &edits);
 		const std::map<std::string, LayerInfo>& layerInfo() const;
 
     private:
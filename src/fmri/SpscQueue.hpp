@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+namespace fmri
+{
+    /**
+     * Bounded lock-free queue for a single producer and a single consumer.
+     *
+     * The producer only writes the tail index and the consumer only
+     * writes the head index, so neither side ever blocks the other.
+     *
+     * @tparam T Element type, must be default constructible and move assignable.
+     */
+    template<class T>
+    class SpscQueue
+    {
+    public:
+        /**
+         * @param capacity Maximum number of queued elements.
+         */
+        explicit SpscQueue(std::size_t capacity) :
+                slots(capacity + 1),
+                head(0),
+                tail(0)
+        {
+        }
+
+        /**
+         * Append an element. Only call this from the producer thread.
+         *
+         * @param item Element to move into the queue. Left untouched if the queue is full.
+         * @return Whether the element was queued.
+         */
+        bool push(T &&item)
+        {
+            const auto current = tail.load(std::memory_order_relaxed);
+            const auto next = (current + 1) % slots.size();
+            if (next == head.load(std::memory_order_acquire)) {
+                return false;
+            }
+
+            slots[current] = std::move(item);
+            tail.store(next, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * Take the oldest element. Only call this from the consumer thread.
+         *
+         * @return The element, or nothing if the queue is empty.
+         */
+        std::optional<T> pop()
+        {
+            const auto current = head.load(std::memory_order_relaxed);
+            if (current == tail.load(std::memory_order_acquire)) {
+                return std::nullopt;
+            }
+
+            std::optional<T> item(std::move(slots[current]));
+            slots[current] = T();
+            head.store((current + 1) % slots.size(), std::memory_order_release);
+            return item;
+        }
+
+    private:
+        std::vector<T> slots;
+        // Keep the indices on separate cache lines, so the threads don't contend.
+        alignas(64) std::atomic<std::size_t> head;
+        alignas(64) std::atomic<std::size_t> tail;
+    };
+}
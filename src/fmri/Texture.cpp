@@ -1,4 +1,6 @@
 #include <algorithm>
+#include <cmath>
+#include <vector>
 #include <glog/logging.h>
 #include <GL/glu.h>
 #include "Texture.hpp"
@@ -8,9 +10,7 @@ using namespace fmri;
 
 Texture::~Texture()
 {
-    if (id != 0) {
-        glDeleteTextures(1, &id);
-    }
+    unload();
 }
 
 Texture &Texture::operator=(Texture && other) noexcept
@@ -18,6 +18,7 @@ Texture &Texture::operator=(Texture && other) noexcept
     std::swap(id, other.id);
     std::swap(width, other.width);
     std::swap(height, other.height);
+    std::swap(layers, other.layers);
     std::swap(data, other.data);
     std::swap(format, other.format);
     return *this;
@@ -34,18 +35,99 @@ void Texture::configure(GLenum target)
     ensureReference();
     CHECK(data) << "No valid data to configure with";
     bind(target);
-    const float color[] = {1, 0, 1}; // Background color for textures.
+    const float color[] = {1, 0, 1, 1}; // Background color for textures.
 
     // Set up (lack of) repetition
-    glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_BORDER);
     glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
     glTexParameterfv(target, GL_TEXTURE_BORDER_COLOR, color);
 
     // Set up texture scaling
     glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST); // Use mipmapping for scaling down
     glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST); // Use nearest pixel when scaling up.
-    gluBuild2DMipmaps(target, format, width, height, format, GL_FLOAT, data.get());
-    data.reset(); // Release data buffer.
+
+    // Rows of 8-bit data are not necessarily 4-byte aligned.
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    if (target == GL_TEXTURE_2D_ARRAY) {
+        GLint maxLayers;
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+        CHECK_LE(layers, maxLayers) << "Too many channels for a texture array.";
+
+        const GLint arrayInternalFormat = format == GL_LUMINANCE ? GL_R8 : internalFormat();
+        glTexImage3D(target, 0, arrayInternalFormat, width, height / layers, layers, 0, arrayFormat(),
+                     GL_UNSIGNED_BYTE, data.get());
+        glGenerateMipmap(target);
+        return;
+    }
+
+    GLint maxSize;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    if (width <= maxSize && height <= maxSize) {
+        // Upload at native size and let the GPU build the mipmaps.
+        glTexImage2D(target, 0, internalFormat(), width, height, 0, format, GL_UNSIGNED_BYTE, data.get());
+        glGenerateMipmap(target);
+    } else {
+        LOG(WARNING) << "Texture of " << width << "x" << height << " exceeds maximum size " << maxSize
+                     << ", scaling down on the CPU.";
+        gluBuild2DMipmaps(target, internalFormat(), width, height, format, GL_UNSIGNED_BYTE, data.get());
+    }
+}
+
+void Texture::configure(GLenum target, Texture &previous)
+{
+    const bool sameStorage = previous.loaded() && previous.width == width && previous.height == height
+                             && previous.layers == layers && previous.format == format;
+    // Textures that are too large were scaled down, so their storage does not match the data.
+    GLint maxSize;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    if (!sameStorage || (target == GL_TEXTURE_2D && (width > maxSize || height > maxSize))) {
+        previous.unload();
+        configure(target);
+        return;
+    }
+
+    CHECK(data) << "No valid data to configure with";
+    std::swap(id, previous.id);
+    previous.unload();
+    bind(target);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    if (target == GL_TEXTURE_2D_ARRAY) {
+        glTexSubImage3D(target, 0, 0, 0, 0, width, height / layers, layers, arrayFormat(), GL_UNSIGNED_BYTE, data.get());
+    } else {
+        glTexSubImage2D(target, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, data.get());
+    }
+    glGenerateMipmap(target);
+}
+
+void Texture::unload()
+{
+    if (id != 0) {
+        glDeleteTextures(1, &id);
+        id = 0;
+    }
+}
+
+bool Texture::loaded() const
+{
+    return id != 0;
+}
+
+std::size_t Texture::memoryUsage() const
+{
+    if (!data) {
+        return 0;
+    }
+
+    // 8 bits per channel, and the mipmap chain adds another third.
+    const std::size_t baseLevel = width * height * getStride();
+    return baseLevel * 4 / 3;
+}
+
+const std::uint8_t *Texture::pixels() const
+{
+    return data.get();
 }
 
 void Texture::ensureReference()
@@ -57,36 +139,93 @@ void Texture::ensureReference()
 }
 
 Texture::Texture(const float *data, int width, int height, GLuint format, int subImages) :
-        Texture(std::make_unique<float[]>(width * height), width, height, format, subImages)
+    id(0),
+    width(width),
+    height(height),
+    layers(subImages),
+    format(format)
 {
-    std::copy_n(data, width * height, this->data.get());
-    preCalc(subImages);
+    std::vector<float> buffer(data, data + width * height * getStride());
+    preCalc(buffer.data(), subImages);
 }
 
 Texture::Texture(std::unique_ptr<float[]> &&data, int width, int height, GLuint format, int subImages) :
     id(0),
     width(width),
     height(height),
+    layers(subImages),
+    format(format)
+{
+    preCalc(data.get(), subImages);
+}
+
+Texture::Texture(std::unique_ptr<std::uint8_t[]> &&data, int width, int height, GLuint format, int subImages) :
+    id(0),
+    width(width),
+    height(height),
+    layers(subImages),
     format(format),
     data(std::move(data))
 {
-    preCalc(subImages);
+    CHECK_EQ(height % subImages, 0) << "Image should be properly divisible!";
 }
 
-void Texture::preCalc(int subImages)
+/**
+ * Rescale the source data and quantise it to 8 bits.
+ *
+ * @param source Source data, will be modified.
+ * @param subImages Number of images to rescale separately.
+ */
+void Texture::preCalc(float *source, int subImages)
 {
     CHECK_EQ(height % subImages, 0) << "Image should be properly divisible!";
 
+    data = quantise(source, width * height * getStride(), subImages);
+}
+
+std::unique_ptr<std::uint8_t[]> Texture::quantise(float *source, std::size_t size, int subImages)
+{
+    auto result = std::make_unique<std::uint8_t[]>(size);
+
     // Rescale images
-    const auto step = width * height * getStride() / subImages;
-    auto cur = data.get();
+    const auto step = size / subImages;
+    auto cur = source;
     for (auto i = 0; i < subImages; ++i) {
         rescale(cur, cur + step, 0, 1);
         std::advance(cur, step);
     }
+
+    std::transform(source, source + size, result.get(), [](float v) {
+        return static_cast<std::uint8_t>(std::lround(v * 255));
+    });
+
+    return result;
 }
 
-int Texture::getStride()
+GLint Texture::internalFormat() const
+{
+    switch (format) {
+        case GL_RGB:
+            return GL_RGB8;
+
+        case GL_LUMINANCE:
+            return GL_LUMINANCE8;
+
+        default:
+            return format;
+    }
+}
+
+/**
+ * @return Pixel format of the data when uploaded as a texture array.
+ */
+GLenum Texture::arrayFormat() const
+{
+    // Luminance is not a valid array format in core profiles, so single channel data goes in red.
+    return format == GL_LUMINANCE ? GL_RED : format;
+}
+
+int Texture::getStride() const
 {
     switch (format) {
         case GL_RGB:
@@ -102,6 +241,13 @@ int Texture::getStride()
 }
 
 Texture::Texture() noexcept :
-id(0)
+id(0),
+layers(1)
+{
+}
+
+Texture::Texture(Texture &&other) noexcept :
+Texture()
 {
+    *this = std::move(other);
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <GL/gl.h>
 
@@ -10,6 +11,11 @@ namespace fmri
      *
      * Encapsulates an OpenGL texture, and enables RAII for it. Copying
      * is disallowed for this reason.
+     *
+     * Source data is rescaled to [0, 1] per sub-image and stored as 8-bit
+     * values, which is also the format it is uploaded in. Sub-images are
+     * stacked vertically in the source data; when configured as
+     * GL_TEXTURE_2D_ARRAY each sub-image becomes its own layer.
      */
     class Texture
     {
@@ -17,6 +23,10 @@ namespace fmri
         Texture() noexcept;
         Texture(const float* data, int width, int height, GLuint format, int subImages = 1);
         Texture(std::unique_ptr<float[]> &&data, int width, int height, GLuint format, int subImages = 1);
+        /**
+         * Create a texture from data that is already quantised, see quantise().
+         */
+        Texture(std::unique_ptr<std::uint8_t[]> &&data, int width, int height, GLuint format, int subImages = 1);
         Texture(Texture &&) noexcept;
         Texture(const Texture &) = delete;
 
@@ -30,19 +40,71 @@ namespace fmri
          * @param target valid target for glBindTexture.
          */
         void bind(GLenum target) const;
+        /**
+         * Upload the texture data to the GPU.
+         *
+         * The CPU-side copy of the data is retained, so the texture can
+         * be uploaded again after unload().
+         *
+         * Luminance data configured as GL_TEXTURE_2D_ARRAY is stored in
+         * the red channel.
+         *
+         * @param target GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY.
+         */
         void configure(GLenum target);
+        /**
+         * Upload the texture data in place of a texture it replaces.
+         *
+         * If the previous texture is loaded with the same size and
+         * format, its storage is taken over and only the pixels are
+         * replaced. Otherwise, this is the same as configure(). Either
+         * way, the previous texture is unloaded afterwards.
+         *
+         * @param target GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY.
+         * @param previous Texture being replaced.
+         */
+        void configure(GLenum target, Texture& previous);
+        /**
+         * Release the GPU-side copy of the texture.
+         */
+        void unload();
+        /**
+         * @return Whether the texture is currently present on the GPU.
+         */
+        bool loaded() const;
+        /**
+         * @return Estimated number of bytes used on the GPU when loaded.
+         */
+        std::size_t memoryUsage() const;
+        /**
+         * @return The quantised CPU-side copy of the data.
+         */
+        const std::uint8_t* pixels() const;
+
+        /**
+         * Rescale data to [0, 1] per sub-image and quantise it to 8 bits.
+         *
+         * @param source Source data, will be modified.
+         * @param size Number of values.
+         * @param subImages Number of equally sized images to rescale separately.
+         */
+        static std::unique_ptr<std::uint8_t[]> quantise(float* source, std::size_t size, int subImages);
 
     private:
         GLuint id;
         int width;
         int height;
+        int layers;
         GLuint format;
-        std::unique_ptr<float[]> data;
+        std::unique_ptr<std::uint8_t[]> data;
 
         void ensureReference();
 
-        void preCalc(int subImages);
+        void preCalc(float* source, int subImages);
+
+        GLint internalFormat() const;
+        GLenum arrayFormat() const;
 
-        int getStride();
+        int getStride() const;
     };
 }
@@ -0,0 +1,62 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "TextureCache.hpp"
+
+using namespace fmri;
+
+/**
+ * FNV-1a over 32-bit words rather than bytes, which is fast enough for
+ * the largest layers.
+ */
+static std::uint64_t hashData(const std::uint8_t *data, std::size_t size)
+{
+    std::uint64_t hash = 0xcbf29ce484222325;
+    auto i = 0u;
+    for (; i + sizeof(std::uint32_t) <= size; i += sizeof(std::uint32_t)) {
+        std::uint32_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * 0x100000001b3;
+    }
+    for (; i < size; ++i) {
+        hash = (hash ^ data[i]) * 0x100000001b3;
+    }
+
+    return hash;
+}
+
+TextureCache &TextureCache::instance()
+{
+    static TextureCache cache;
+    return cache;
+}
+
+std::shared_ptr<VirtualTexture> TextureCache::get(const float *data, int width, int height, int channels)
+{
+    const auto size = static_cast<std::size_t>(width) * height * channels;
+    std::vector<float> buffer(data, data + size);
+    auto quantised = Texture::quantise(buffer.data(), size, channels);
+    const Key key(hashData(quantised.get(), size), width, height, channels);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (auto it = textures.find(key); it != textures.end()) {
+        auto texture = it->second.lock();
+        if (texture && texture->holds(quantised.get())) {
+            return texture;
+        }
+    }
+
+    // Forget textures nobody uses anymore.
+    for (auto it = textures.begin(); it != textures.end();) {
+        it = it->second.expired() ? textures.erase(it) : std::next(it);
+    }
+
+    auto texture = std::make_shared<VirtualTexture>(std::move(quantised), width, height, channels);
+    textures[key] = texture;
+    return texture;
+}
+
+std::size_t TextureCache::sharedMemoryUsage(const std::shared_ptr<VirtualTexture> &texture)
+{
+    return texture->memoryUsage() / std::max(1L, texture.use_count());
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include "VirtualTexture.hpp"
+
+namespace fmri
+{
+    /**
+     * Shares feature map textures between drawables showing the same data.
+     *
+     * Textures are keyed by a hash of their quantised contents and size,
+     * and live as long as any drawable holds on to them. A layer and the
+     * animations starting from it therefore upload its channels only once.
+     * Hash collisions are caught by comparing against the quantised
+     * channels the texture keeps anyway. Data that only differs below 8
+     * bits looks the same on screen, so it shares a texture too.
+     *
+     * Textures are created on the loader thread, so get() is thread-safe.
+     */
+    class TextureCache
+    {
+    public:
+        static TextureCache& instance();
+
+        /**
+         * Get the texture for some channels, creating it if no drawable holds it yet.
+         *
+         * @param data Channels of width x height values, stacked.
+         * @param width
+         * @param height
+         * @param channels
+         * @see VirtualTexture::VirtualTexture(std::unique_ptr<std::uint8_t[]>&&, int, int, int)
+         */
+        std::shared_ptr<VirtualTexture> get(const float* data, int width, int height, int channels);
+
+        /**
+         * @return The GPU memory of a cached texture, divided over the drawables sharing it.
+         */
+        static std::size_t sharedMemoryUsage(const std::shared_ptr<VirtualTexture>& texture);
+
+    private:
+        typedef std::tuple<std::uint64_t, int, int, int> Key;
+
+        std::mutex mutex;
+        std::map<Key, std::weak_ptr<VirtualTexture>> textures;
+
+        TextureCache() noexcept = default;
+    };
+}
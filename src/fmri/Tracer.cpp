@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <glog/logging.h>
+#include "Tracer.hpp"
+#include "utils.hpp"
+
+using namespace fmri;
+
+Tracer::Span::Span(const char *name, std::string_view layer) :
+    name(name),
+    layer(layer),
+    active(Tracer::instance().enabled())
+{
+    if (active) {
+        start = clock::now();
+    }
+}
+
+Tracer::Span::~Span()
+{
+    if (!active) {
+        return;
+    }
+
+    const auto end = clock::now();
+    auto& buffer = Tracer::instance().threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.add({name, buffer.input, std::string(layer), start, end - start});
+}
+
+void Tracer::ThreadBuffer::add(Event &&event)
+{
+    if (events.size() < MAX_EVENTS) {
+        events.push_back(std::move(event));
+    } else {
+        events[next] = std::move(event);
+        next = (next + 1) % MAX_EVENTS;
+        ++dropped;
+    }
+}
+
+Tracer::Tracer() noexcept :
+    enabled_(false)
+{
+}
+
+Tracer &Tracer::instance()
+{
+    static Tracer tracer;
+    return tracer;
+}
+
+void Tracer::start(const std::string &path)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->path = path;
+        epoch = clock::now();
+    }
+
+    if (!enabled_.exchange(true)) {
+        // GLUT may exit without returning from its main loop.
+        std::atexit([]() { Tracer::instance().stop(); });
+    }
+}
+
+void Tracer::stop()
+{
+    if (enabled_.exchange(false)) {
+        write();
+    }
+}
+
+Tracer::ThreadBuffer &Tracer::threadBuffer()
+{
+    // Buffers are shared with the tracer, so they outlive their thread.
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer) {
+        buffer = std::make_shared<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(mutex);
+        buffer->id = buffers.size() + 1;
+        buffers.push_back(buffer);
+    }
+
+    return *buffer;
+}
+
+void Tracer::setThreadName(std::string_view name)
+{
+    auto& buffer = instance().threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.name = name;
+}
+
+void Tracer::setInput(std::string_view input)
+{
+    auto& buffer = instance().threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.input = input;
+}
+
+void Tracer::write()
+{
+    using namespace std::chrono;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ofstream out(path);
+    if (!out) {
+        LOG(ERROR) << "Failed to open trace file " << path;
+        return;
+    }
+
+    const auto micros = [](clock::duration d) { return duration_cast<duration<double, std::micro>>(d).count(); };
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    std::size_t events = 0, dropped = 0;
+    for (auto &buffer : buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+
+        if (!buffer->name.empty()) {
+            out << (first ? "" : ",\n") << R"({"ph":"M","name":"thread_name","pid":1,"tid":)" << buffer->id
+                << R"(,"args":{"name":)";
+            writeJsonString(out, buffer->name);
+            out << "}}";
+            first = false;
+        }
+
+        // Oldest first, in case the ring buffer wrapped around.
+        std::rotate(buffer->events.begin(), buffer->events.begin() + buffer->next, buffer->events.end());
+        for (auto &event : buffer->events) {
+            out << (first ? "" : ",\n") << R"({"ph":"X","pid":1,"tid":)" << buffer->id << ",\"name\":";
+            writeJsonString(out, event.name);
+            out << ",\"ts\":" << micros(event.start - epoch) << ",\"dur\":" << micros(event.duration) << ",\"args\":{";
+            if (!event.input.empty()) {
+                out << "\"input\":";
+                writeJsonString(out, event.input);
+            }
+            if (!event.layer.empty()) {
+                out << (event.input.empty() ? "" : ",") << "\"layer\":";
+                writeJsonString(out, event.layer);
+            }
+            out << "}}";
+            first = false;
+        }
+
+        events += buffer->events.size();
+        dropped += buffer->dropped;
+        buffer->events.clear();
+        buffer->next = 0;
+        buffer->dropped = 0;
+    }
+    out << "\n]}\n";
+
+    LOG(INFO) << "Wrote " << events << " trace events to " << path;
+    if (dropped > 0) {
+        LOG(WARNING) << "Dropped the " << dropped << " oldest trace events, only the last " << MAX_EVENTS
+                     << " of every thread are kept";
+    }
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fmri
+{
+    /**
+     * Singleton class recording a timeline in the Chrome trace event format.
+     *
+     * Spans are recorded per thread and tagged with the input the thread
+     * is working on, and optionally a layer. The resulting file can be
+     * opened in chrome://tracing or Perfetto.
+     *
+     * When tracing is disabled, a span costs a single atomic load. Each
+     * thread keeps only its most recent events, so long sessions that add
+     * a span every frame do not grow without bound.
+     */
+    class Tracer
+    {
+    public:
+        typedef std::chrono::steady_clock clock;
+
+        /**
+         * Scoped span on the timeline of the current thread.
+         */
+        class Span
+        {
+        public:
+            /**
+             * @param name Name of the span, must outlive the tracer. Normally a literal.
+             * @param layer Layer the span applies to, if any. Must outlive the span.
+             */
+            explicit Span(const char *name, std::string_view layer = {});
+            ~Span();
+
+            Span(const Span &) = delete;
+            Span &operator=(const Span &) = delete;
+
+        private:
+            const char *name;
+            std::string_view layer;
+            bool active;
+            clock::time_point start;
+        };
+
+        static Tracer& instance();
+
+        /**
+         * Start recording. The trace is written when stop() is called, or at exit.
+         *
+         * @param path File to write the trace to.
+         */
+        void start(const std::string& path);
+        /**
+         * Stop recording and write the trace file.
+         */
+        void stop();
+
+        bool enabled() const
+        {
+            return enabled_.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Name the calling thread in the trace.
+         */
+        static void setThreadName(std::string_view name);
+        /**
+         * Tag subsequent spans of the calling thread with an input.
+         */
+        static void setInput(std::string_view input);
+
+    private:
+        // Events kept per thread, about 100 bytes each.
+        static constexpr std::size_t MAX_EVENTS = 1 << 16;
+
+        struct Event
+        {
+            const char *name;
+            std::string input;
+            std::string layer;
+            clock::time_point start;
+            clock::duration duration;
+        };
+
+        struct ThreadBuffer
+        {
+            std::mutex mutex;
+            std::size_t id;
+            std::string name;
+            std::string input;
+            // Ring buffer of events, the oldest at next once full.
+            std::vector<Event> events;
+            std::size_t next = 0;
+            std::size_t dropped = 0;
+
+            void add(Event&& event);
+        };
+
+        std::atomic<bool> enabled_;
+        std::string path;
+        clock::time_point epoch;
+        std::mutex mutex;
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+
+        Tracer() noexcept;
+
+        ThreadBuffer& threadBuffer();
+        void write();
+    };
+}
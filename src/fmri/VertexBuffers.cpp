@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "VertexBuffers.hpp"
+
+using namespace fmri;
+
+PackedPositions::PackedPositions(const std::vector<float> &positions) :
+        coordinates_(positions.size())
+{
+    float extent = 0;
+    for (auto f : positions) {
+        extent = std::max(extent, std::abs(f));
+    }
+
+    constexpr auto limit = std::numeric_limits<std::int16_t>::max();
+    if (extent > 0) {
+        step_ = std::exp2(std::ceil(std::log2(extent / limit)));
+    }
+
+    std::transform(positions.begin(), positions.end(), coordinates_.begin(), [this](float f) {
+        return static_cast<std::int16_t>(std::clamp<long>(std::lround(f / step_), -limit, limit));
+    });
+}
+
+void PackedPositions::bind() const
+{
+    glScalef(step_, step_, step_);
+    glVertexPointer(3, GL_SHORT, 0, coordinates_.data());
+}
+
+const std::vector<std::int16_t> &PackedPositions::coordinates() const
+{
+    return coordinates_;
+}
+
+float PackedPositions::step() const
+{
+    return step_;
+}
+
+std::size_t PackedPositions::bytes() const
+{
+    return coordinates_.size() * sizeof(std::int16_t);
+}
+
+IndexBuffer::IndexBuffer(const std::vector<unsigned int> &indices)
+{
+    const auto max = indices.empty() ? 0 : *std::max_element(indices.begin(), indices.end());
+    if (max <= std::numeric_limits<std::uint16_t>::max()) {
+        shortIndices.assign(indices.begin(), indices.end());
+    } else {
+        longIndices.assign(indices.begin(), indices.end());
+    }
+}
+
+void IndexBuffer::draw(GLenum mode) const
+{
+    if (!longIndices.empty()) {
+        glDrawElements(mode, longIndices.size(), GL_UNSIGNED_INT, longIndices.data());
+    } else if (!shortIndices.empty()) {
+        glDrawElements(mode, shortIndices.size(), GL_UNSIGNED_SHORT, shortIndices.data());
+    }
+}
+
+std::uint32_t IndexBuffer::at(std::size_t i) const
+{
+    return longIndices.empty() ? shortIndices[i] : longIndices[i];
+}
+
+std::size_t IndexBuffer::size() const
+{
+    return shortIndices.size() + longIndices.size();
+}
+
+std::size_t IndexBuffer::bytes() const
+{
+    return shortIndices.size() * sizeof(std::uint16_t) + longIndices.size() * sizeof(std::uint32_t);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <GL/gl.h>
+
+namespace fmri
+{
+    /**
+     * Vertex positions stored as 16-bit fixed point numbers.
+     *
+     * Positions are relative to the layer origin, so their range is
+     * small. The step size is chosen as a power of two, which keeps the
+     * node grid of a layer exact for all but the very largest layers.
+     */
+    class PackedPositions
+    {
+    public:
+        PackedPositions() = default;
+        /**
+         * @param positions Three coordinates per vertex.
+         */
+        explicit PackedPositions(const std::vector<float>& positions);
+
+        /**
+         * Set the vertex pointer, and scale the current matrix to match.
+         *
+         * Should be called between glPushMatrix() and glPopMatrix().
+         */
+        void bind() const;
+
+        const std::vector<std::int16_t>& coordinates() const;
+        /**
+         * @return Size of a single fixed point step, in world units.
+         */
+        float step() const;
+        std::size_t bytes() const;
+
+    private:
+        std::vector<std::int16_t> coordinates_;
+        float step_ = 1;
+    };
+
+    /**
+     * Element indices, stored as 16-bit values whenever they all fit.
+     */
+    class IndexBuffer
+    {
+    public:
+        IndexBuffer() = default;
+        explicit IndexBuffer(const std::vector<unsigned int>& indices);
+
+        /**
+         * Draw indexed primitives from the currently enabled arrays.
+         *
+         * @param mode Primitive type, as for glDrawElements().
+         */
+        void draw(GLenum mode) const;
+
+        std::uint32_t at(std::size_t i) const;
+        std::size_t size() const;
+        std::size_t bytes() const;
+
+    private:
+        std::vector<std::uint16_t> shortIndices;
+        std::vector<std::uint32_t> longIndices;
+    };
+}
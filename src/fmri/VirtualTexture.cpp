@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include "VirtualTexture.hpp"
+#include "PagePool.hpp"
+#include "glutils.hpp"
+
+using namespace fmri;
+
+VirtualTexture::VirtualTexture() noexcept :
+        owner(0),
+        width(0),
+        height(0),
+        channels(0),
+        lowResSize(0),
+        paged(false),
+        requested(false),
+        users(0)
+{
+}
+
+VirtualTexture::VirtualTexture(std::unique_ptr<std::uint8_t[]> &&quantised, int width, int height, int channels) :
+        owner(PagePool::newOwner()),
+        width(width),
+        height(height),
+        channels(channels),
+        paged(false),
+        requested(false),
+        users(0)
+{
+    const auto channelSize = static_cast<std::size_t>(width) * height;
+    const auto scale = static_cast<float>(LOW_RES_SIZE) / std::max(width, height);
+    if (scale >= 1) {
+        // Small enough to upload as is.
+        lowRes = Texture(std::move(quantised), width, height * channels, GL_LUMINANCE, channels);
+        lowResSize = std::max(width, height);
+        return;
+    }
+
+    const auto lowWidth = std::max(1, static_cast<int>(std::lround(width * scale)));
+    const auto lowHeight = std::max(1, static_cast<int>(std::lround(height * scale)));
+    const auto lowChannelSize = static_cast<std::size_t>(lowWidth) * lowHeight;
+    auto low = std::make_unique<std::uint8_t[]>(lowChannelSize * channels);
+    for (auto channel = 0; channel < channels; ++channel) {
+        const cv::Mat source(height, width, CV_8UC1, quantised.get() + channel * channelSize);
+        cv::Mat target(lowHeight, lowWidth, CV_8UC1, low.get() + channel * lowChannelSize);
+        cv::resize(source, target, target.size(), 0, 0, cv::INTER_AREA);
+    }
+
+    lowRes = Texture(std::move(low), lowWidth, lowHeight * channels, GL_LUMINANCE, channels);
+    lowResSize = std::max(lowWidth, lowHeight);
+    pixels = std::move(quantised);
+    paged = true;
+}
+
+VirtualTexture::VirtualTexture(VirtualTexture &&other) noexcept :
+        VirtualTexture()
+{
+    *this = std::move(other);
+}
+
+VirtualTexture::~VirtualTexture()
+{
+    releasePages();
+}
+
+VirtualTexture &VirtualTexture::operator=(VirtualTexture &&other) noexcept
+{
+    std::swap(owner, other.owner);
+    std::swap(width, other.width);
+    std::swap(height, other.height);
+    std::swap(channels, other.channels);
+    std::swap(pixels, other.pixels);
+    std::swap(lowRes, other.lowRes);
+    std::swap(lowResSize, other.lowResSize);
+    std::swap(paged, other.paged);
+    std::swap(requested, other.requested);
+    std::swap(users, other.users);
+    return *this;
+}
+
+void VirtualTexture::configure()
+{
+    if (users++ == 0) {
+        lowRes.configure(GL_TEXTURE_2D_ARRAY);
+    }
+}
+
+void VirtualTexture::configure(VirtualTexture &previous)
+{
+    if (&previous == this) {
+        // Same data as before, the user carries over.
+        return;
+    }
+
+    if (users > 0 || previous.users > 1) {
+        configure();
+        previous.unload();
+        return;
+    }
+
+    lowRes.configure(GL_TEXTURE_2D_ARRAY, previous.lowRes);
+    users = 1;
+    previous.users = 0;
+    previous.releasePages();
+}
+
+void VirtualTexture::unload()
+{
+    if (users > 0 && --users == 0) {
+        lowRes.unload();
+        releasePages();
+    }
+}
+
+std::size_t VirtualTexture::memoryUsage() const
+{
+    return lowRes.memoryUsage();
+}
+
+bool VirtualTexture::holds(const std::uint8_t *pixels) const
+{
+    // Textures small enough to upload as is only keep their data in the low resolution copy.
+    const auto own = paged ? this->pixels.get() : lowRes.pixels();
+    return std::equal(pixels, pixels + static_cast<std::size_t>(width) * height * channels, own);
+}
+
+void VirtualTexture::draw(int n, const float *vertexBuffer, const float *textureCoords, float alpha)
+{
+    if (!paged) {
+        drawImageTileArray(n, vertexBuffer, textureCoords, lowRes, alpha);
+        return;
+    }
+
+    GLfloat modelView[16], projection[16];
+    GLint viewport[4];
+    glGetFloatv(GL_MODELVIEW_MATRIX, modelView);
+    glGetFloatv(GL_PROJECTION_MATRIX, projection);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    // Size on screen in pixels of a unit at unit distance.
+    const auto pixelsPerUnit = projection[5] * viewport[3] / 2;
+
+    auto &pool = PagePool::instance();
+    const auto channelSize = static_cast<std::size_t>(width) * height;
+    std::vector<std::pair<const Texture *, int>> pages;
+    lowResVertices.clear();
+    lowResCoords.clear();
+
+    for (auto tile = 0; tile < n / 4; ++tile) {
+        const auto vertices = vertexBuffer + 12 * tile;
+        const auto coords = textureCoords + 12 * tile;
+        const auto channel = static_cast<int>(coords[2]);
+
+        const Texture *page = nullptr;
+        std::array<float, 3> center = {0, 0, 0};
+        for (auto i = 0; i < 12; ++i) {
+            center[i % 3] += vertices[i] / 4;
+        }
+        const auto depth = -(modelView[2] * center[0] + modelView[6] * center[1] + modelView[10] * center[2] + modelView[14]);
+        if (depth > 0) {
+            // Quads are squares, so their size follows from the diagonal.
+            const auto diagonal = std::hypot(vertices[6] - vertices[0], vertices[7] - vertices[1], vertices[8] - vertices[2]);
+            if (diagonal / std::sqrt(2.f) * pixelsPerUnit / depth > lowResSize) {
+                requested = true;
+                page = pool.page(owner, channel, pixels.get() + channel * channelSize, width, height);
+            }
+        }
+
+        if (page != nullptr) {
+            pages.emplace_back(page, tile);
+        } else {
+            lowResVertices.insert(lowResVertices.end(), vertices, vertices + 12);
+            lowResCoords.insert(lowResCoords.end(), coords, coords + 12);
+        }
+    }
+
+    if (!lowResVertices.empty()) {
+        drawImageTileArray(lowResVertices.size() / 3, lowResVertices.data(), lowResCoords.data(), lowRes, alpha);
+    }
+
+    for (auto [page, tile] : pages) {
+        std::array<float, 12> coords;
+        std::copy_n(textureCoords + 12 * tile, coords.size(), coords.begin());
+        for (auto i = 2u; i < coords.size(); i += 3) {
+            coords[i] = 0;
+        }
+        drawImageTileArray(4, vertexBuffer + 12 * tile, coords.data(), *page, alpha);
+    }
+}
+
+void VirtualTexture::releasePages()
+{
+    if (requested) {
+        PagePool::instance().release(owner);
+        requested = false;
+    }
+}
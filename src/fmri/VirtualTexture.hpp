@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Texture.hpp"
+
+namespace fmri
+{
+    /**
+     * Texture array of feature maps, streamed in at the resolution needed.
+     *
+     * Only a low resolution copy of every channel is uploaded with the
+     * drawable. Channels that are drawn larger than that copy on screen
+     * are paged in at full resolution from the PagePool, within its
+     * budget. Channels that are small enough are never paged.
+     *
+     * The full resolution data is kept on the CPU, quantised to 8 bits.
+     * A texture can be shared by several drawables, see TextureCache, so
+     * it counts its users and is uploaded once for all of them.
+     */
+    class VirtualTexture
+    {
+    public:
+        VirtualTexture() noexcept;
+        /**
+         * @param pixels Channels of width x height values, stacked and quantised per channel, see Texture::quantise().
+         * @param width
+         * @param height
+         * @param channels
+         */
+        VirtualTexture(std::unique_ptr<std::uint8_t[]>&& pixels, int width, int height, int channels);
+        VirtualTexture(VirtualTexture&& other) noexcept;
+        VirtualTexture(const VirtualTexture&) = delete;
+        ~VirtualTexture();
+
+        VirtualTexture& operator=(VirtualTexture&& other) noexcept;
+        VirtualTexture& operator=(const VirtualTexture&) = delete;
+
+        /**
+         * Upload the low resolution channels, or add a user if they already are.
+         */
+        void configure();
+        /**
+         * Upload the low resolution channels in place of a texture this one replaces.
+         *
+         * The previous texture loses a user. Its GPU resources are only
+         * taken over if that was the last one.
+         *
+         * @param previous Texture being replaced, may be this one.
+         * @see Texture::configure(GLenum, Texture&)
+         */
+        void configure(VirtualTexture& previous);
+        /**
+         * Remove a user, releasing the low resolution channels and any pages after the last.
+         */
+        void unload();
+        /**
+         * @return Estimated number of bytes used on the GPU when loaded, not counting pages.
+         */
+        std::size_t memoryUsage() const;
+
+        /**
+         * @param pixels Quantised channels of the same size as this texture.
+         * @return Whether this texture holds exactly these channels.
+         */
+        bool holds(const std::uint8_t* pixels) const;
+
+        /**
+         * Draw a series of tiles, like drawImageTileArray().
+         *
+         * The tiles are quads, with the channel as the third texture
+         * coordinate. Tiles that cover more pixels than the low resolution
+         * channels have are drawn from full resolution pages if possible.
+         */
+        void draw(int n, const float* vertexBuffer, const float* textureCoords, float alpha);
+
+    private:
+        static constexpr int LOW_RES_SIZE = 16;
+
+        std::uint64_t owner;
+        int width;
+        int height;
+        int channels;
+        // Full resolution channels, only kept if they can be paged.
+        std::unique_ptr<std::uint8_t[]> pixels;
+        Texture lowRes;
+        int lowResSize;
+        bool paged;
+        // Whether pages were ever requested, only then the pool needs to be told.
+        bool requested;
+        // Drawables that loaded this texture.
+        int users;
+
+        std::vector<float> lowResVertices;
+        std::vector<float> lowResCoords;
+
+        void releasePages();
+    };
+}
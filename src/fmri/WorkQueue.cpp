@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <glog/logging.h>
+#include "WorkQueue.hpp"
+#include "Tracer.hpp"
+
+using namespace fmri;
+
+WorkQueue::WorkQueue(std::size_t threads, std::size_t capacity) :
+        running(0),
+        stopping(false)
+{
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    this->capacity = capacity != 0 ? capacity : 2 * threads;
+
+    workers.reserve(threads);
+    for (auto i = 0u; i < threads; ++i) {
+        workers.emplace_back(&WorkQueue::work, this);
+    }
+}
+
+WorkQueue::~WorkQueue()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    jobAvailable.notify_all();
+
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+void WorkQueue::submit(Job job)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    spaceAvailable.wait(lock, [this]() { return jobs.size() < capacity; });
+    jobs.push_back(std::move(job));
+    lock.unlock();
+
+    jobAvailable.notify_one();
+}
+
+void WorkQueue::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this]() { return jobs.empty() && running == 0; });
+}
+
+void WorkQueue::work()
+{
+    Tracer::setThreadName("worker");
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        jobAvailable.wait(lock, [this]() { return stopping || !jobs.empty(); });
+        if (jobs.empty()) {
+            // Only reachable when stopping, and all work is done.
+            return;
+        }
+
+        auto job = std::move(jobs.front());
+        jobs.pop_front();
+        ++running;
+        lock.unlock();
+        spaceAvailable.notify_one();
+
+        try {
+            job();
+        } catch (std::exception &e) {
+            LOG(ERROR) << "Background job failed: " << e.what();
+        }
+
+        lock.lock();
+        --running;
+        if (jobs.empty() && running == 0) {
+            idle.notify_all();
+        }
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fmri
+{
+    /**
+     * Fixed-size pool of worker threads fed by a bounded queue.
+     *
+     * Submitting work blocks while the queue is full, which keeps the
+     * memory held by queued jobs bounded. The destructor finishes all
+     * submitted jobs before returning.
+     */
+    class WorkQueue
+    {
+    public:
+        typedef std::function<void()> Job;
+
+        /**
+         * @param threads Number of worker threads. 0 uses the number of hardware threads.
+         * @param capacity Maximum number of queued jobs. 0 uses twice the number of threads.
+         */
+        explicit WorkQueue(std::size_t threads = 0, std::size_t capacity = 0);
+        WorkQueue(const WorkQueue&) = delete;
+        ~WorkQueue();
+
+        WorkQueue& operator=(const WorkQueue&) = delete;
+
+        /**
+         * Queue a job, waiting for space in the queue if needed.
+         */
+        void submit(Job job);
+
+        /**
+         * Wait until all submitted jobs have finished.
+         */
+        void wait();
+
+    private:
+        std::size_t capacity;
+        std::size_t running;
+        bool stopping;
+        std::deque<Job> jobs;
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable jobAvailable;
+        std::condition_variable spaceAvailable;
+        std::condition_variable idle;
+
+        void work();
+    };
+}
@@ -3,9 +3,9 @@
 #include <vector>
 #include <cstring>
 #include <glog/logging.h>
-#include <chrono>
-#include <thread>
 #include "glutils.hpp"
+#include "FrameProfiler.hpp"
+#include "ShaderProgram.hpp"
 
 #ifdef FREEGLUT
 #include <GL/freeglut.h>
@@ -39,17 +39,28 @@ void fmri::changeWindowSize(int w, int h)
     glMatrixMode(GL_MODELVIEW);
 }
 
-void fmri::renderText(std::string_view text, int x, int y)
+static bool textEnabled = true;
+
+void fmri::setTextRendering(bool enabled)
+{
+    textEnabled = enabled;
+}
+
+static constexpr auto TEXT_LINE_HEIGHT = 12;
+
+/**
+ * Draw a bitmap string from the current raster position.
+ */
+static void drawString(std::string_view text, [[maybe_unused]] int x, [[maybe_unused]] int y)
 {
     constexpr auto font = GLUT_BITMAP_HELVETICA_10;
-    glRasterPos2i(x, y);
 #ifdef FREEGLUT
     std::string textBuffer(text);
     glutBitmapString(font, reinterpret_cast<const unsigned char *>(textBuffer.c_str()));
 #else
     for (char c : text) {
         if (c == '\n') {
-            y += 12;
+            y += TEXT_LINE_HEIGHT;
             glRasterPos2i(x, y);
         } else {
             glutBitmapCharacter(font, c);
@@ -58,23 +69,26 @@ void fmri::renderText(std::string_view text, int x, int y)
 #endif
 }
 
-void fmri::throttleIdleFunc()
+void fmri::renderText(std::string_view text, int x, int y)
 {
-    using namespace std::chrono;
-
-    constexpr duration<double, ratio<1, 60>> refreshRate(1);
-
-    static auto lastCalled = steady_clock::now();
-
-    const auto now = steady_clock::now();
+    if (!textEnabled) {
+        return;
+    }
 
-    const auto diff = now - lastCalled;
+    glRasterPos2i(x, y);
+    drawString(text, x, y);
+}
 
-    if (diff < refreshRate) {
-        this_thread::sleep_for(refreshRate - diff);
+void fmri::renderTextBelow(std::string_view text, int lines)
+{
+    if (!textEnabled) {
+        return;
     }
 
-    lastCalled = now;
+    glRasterPos2i(0, 0);
+    // Move the raster position in window coordinates, so the offset does not depend on the distance.
+    glBitmap(0, 0, 0, 0, 0, -TEXT_LINE_HEIGHT * lines, nullptr);
+    drawString(text, 0, 0);
 }
 
 void fmri::restorePerspectiveProjection() {
@@ -117,11 +131,83 @@ void fmri::drawImageTiles(int n, const float *vertexBuffer, const float *texture
     glTexCoordPointer(2, GL_FLOAT, 0, textureCoords);
     glVertexPointer(3, GL_FLOAT, 0, vertexBuffer);
     glDrawArrays(GL_QUADS, 0, n);
+    FrameProfiler::instance().countDraw(n);
     glDisable(GL_TEXTURE_2D);
     glDisableClientState(GL_VERTEX_ARRAY);
     glDisableClientState(GL_TEXTURE_COORD_ARRAY);
 }
 
+static const char TILE_ARRAY_VERTEX_SHADER[] = R"glsl(
+#version 130
+
+out vec3 texCoord;
+
+void main()
+{
+    texCoord = gl_MultiTexCoord0.stp;
+    gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;
+}
+)glsl";
+
+static const char TILE_ARRAY_FRAGMENT_SHADER[] = R"glsl(
+#version 130
+
+uniform sampler2DArray tiles;
+uniform float alpha;
+
+in vec3 texCoord;
+
+void main()
+{
+    gl_FragColor = vec4(vec3(texture(tiles, texCoord).r), alpha);
+}
+)glsl";
+
+// Program for drawImageTileArray(), released by unloadImageTileArray().
+static ShaderProgram tileArrayProgram;
+static GLint tileArrayAlphaLocation = -1;
+
+/**
+ * Prepare to draw tiles from a texture array, compiling the program on first use.
+ */
+static void useTileArrayProgram(float alpha)
+{
+    if (!tileArrayProgram) {
+        tileArrayProgram = ShaderProgram(TILE_ARRAY_VERTEX_SHADER, TILE_ARRAY_FRAGMENT_SHADER);
+        tileArrayAlphaLocation = tileArrayProgram.uniform("alpha");
+        tileArrayProgram.use();
+        glUniform1i(tileArrayProgram.uniform("tiles"), 0);
+    }
+
+    tileArrayProgram.use();
+    glUniform1f(tileArrayAlphaLocation, alpha);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glEnableClientState(GL_VERTEX_ARRAY);
+}
+
+static void releaseTileArrayProgram()
+{
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glUseProgram(0);
+}
+
+void fmri::drawImageTileArray(int n, const float *vertexBuffer, const float *textureCoords, const Texture &texture,
+                              float alpha)
+{
+    useTileArrayProgram(alpha);
+    texture.bind(GL_TEXTURE_2D_ARRAY);
+    glTexCoordPointer(3, GL_FLOAT, 0, textureCoords);
+    glVertexPointer(3, GL_FLOAT, 0, vertexBuffer);
+    glDrawArrays(GL_QUADS, 0, n);
+    FrameProfiler::instance().countDraw(n);
+    releaseTileArrayProgram();
+}
+
+void fmri::unloadImageTileArray()
+{
+    tileArrayProgram = ShaderProgram();
+}
 
 void fmri::registerErrorCallbacks()
 {
@@ -150,3 +236,8 @@ void fmri::setGlColor(const Color &c)
         glColor3fv(c.data());
     }
 }
+
+void fmri::setGlColor(const PackedColor &c)
+{
+    glColor4ubv(c.data());
+}
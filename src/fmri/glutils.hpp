@@ -30,9 +30,22 @@ namespace fmri {
     void renderText(std::string_view text, int x = 0, int y = 0);
 
     /**
-     * Slow down until the idle func is being called a reasonable amount of times.
+     * Draw a bitmap string a number of text lines below the current location.
+     *
+     * @param text The text to draw.
+     * @param lines Number of lines to move down, in screen space.
+     */
+    void renderTextBelow(std::string_view text, int lines);
+
+    /**
+     * Enable or disable text rendering.
+     *
+     * GLUT bitmap fonts are unavailable without a window, so offscreen
+     * rendering turns renderText into a no-op.
+     *
+     * @param enabled
      */
-    void throttleIdleFunc();
+    void setTextRendering(bool enabled);
 
     void setOrthographicProjection();
 
@@ -51,6 +64,29 @@ namespace fmri {
     void
     drawImageTiles(int n, const float *vertexBuffer, const float *textureCoords, const Texture &texture, float alpha);
 
+    /**
+     * Draw a series of tiles from a texture array in a single call.
+     *
+     * Texture coordinates have three components, the last being the
+     * array layer. Since the fixed function pipeline cannot sample
+     * texture arrays, this uses a small GLSL 1.30 program.
+     *
+     * @param n Number of vertices
+     * @param vertexBuffer
+     * @param textureCoords
+     * @param texture Texture configured as GL_TEXTURE_2D_ARRAY.
+     */
+    void
+    drawImageTileArray(int n, const float *vertexBuffer, const float *textureCoords, const Texture &texture, float alpha);
+
+    /**
+     * Release the program used by drawImageTileArray().
+     *
+     * Call this while the context is still current, before it is destroyed.
+     * The program is compiled again when it is next needed.
+     */
+    void unloadImageTileArray();
+
     /**
      * Attempt to register error handlers in GLUT.
      *
@@ -63,4 +99,5 @@ namespace fmri {
      * @param c
      */
     void setGlColor(const Color& c);
+    void setGlColor(const PackedColor& c);
 }
@@ -13,23 +13,62 @@
 #include "LayerVisualisation.hpp"
 #include "Range.hpp"
 #include "visualisations.hpp"
+#include "OffscreenContext.hpp"
+#include "PerfHarness.hpp"
+#include "Tracer.hpp"
 
 using namespace std;
 using namespace fmri;
 
+static void startTracing(const Options& options)
+{
+    if (!options.tracePath().empty()) {
+        Tracer::setThreadName("main");
+        Tracer::instance().start(options.tracePath());
+    }
+}
+
 int main(int argc, char *argv[])
 {
+    const auto start = std::chrono::steady_clock::now();
     google::InitGoogleLogging(argv[0]);
     google::InstallFailureSignalHandler();
 
-    registerErrorCallbacks();
+    // GLUT takes its own arguments, like -display, out of argv before the full parse.
+    const bool windowed = Options::needsWindow(argc, argv);
+    if (windowed) {
+        registerErrorCallbacks();
+        glutInit(&argc, argv);
+    }
+
+    Options options(argc, argv);
+
+    if (!options.perfPath().empty()) {
+        OffscreenContext context(options.frameSize()[0], options.frameSize()[1]);
+        const bool passed = PerfHarness(options).run(context, std::chrono::steady_clock::now() - start);
+        RenderingState::instance().glUnload();
+
+        google::ShutdownGoogleLogging();
+        return passed ? 0 : 1;
+    }
+
+    if (!options.offscreenPath().empty()) {
+        startTracing(options);
+        OffscreenContext context(options.frameSize()[0], options.frameSize()[1]);
+        RenderingState::instance().renderOffscreen(options, context);
+        Tracer::instance().stop();
+
+        google::ShutdownGoogleLogging();
+        return 0;
+    }
+
+    CHECK(windowed) << "Options chose a different mode than the first look at them.";
 
-    glutInit(&argc, argv);
     glutInitDisplayMode(GLUT_DEPTH | GLUT_DOUBLE | GLUT_RGBA | GLUT_ALPHA);
     glutCreateWindow(argv[0]);
 
     // Prepare data for simulations
-    Options options(argc, argv);
+    startTracing(options);
     RenderingState::instance().loadOptions(options);
 
     // Register callbacks
@@ -1,4 +1,8 @@
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
 #include <caffe/util/math_functions.hpp>
+#include <glog/logging.h>
 #include "utils.hpp"
 
 float fmri::LAYER_X_OFFSET = 10;
@@ -16,3 +20,48 @@ const std::vector<float> & fmri::animate(const std::vector<float> &start, const
 
     return vertexBuffer;
 }
+
+void fmri::ensureDirectory(const std::string &dir)
+{
+    struct stat s;
+    if (stat(dir.c_str(), &s) == 0) {
+        CHECK(S_ISDIR(s.st_mode)) << dir << " already exists and is not a directory." << std::endl;
+        return;
+    }
+
+    switch (errno) {
+        case ENOENT:
+            PCHECK(mkdir(dir.c_str(), 0777) == 0) << "Couldn't create directory";
+            return;
+
+        default:
+            PLOG(ERROR) << "Unusable directory " << dir;
+            break;
+    }
+}
+
+void fmri::writeJsonString(std::ostream &out, std::string_view str)
+{
+    out << '"';
+    for (char c : str) {
+        switch (c) {
+            case '"':
+                out << "\\\"";
+                break;
+
+            case '\\':
+                out << "\\\\";
+                break;
+
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out << escaped;
+                } else {
+                    out << c;
+                }
+        }
+    }
+    out << '"';
+}
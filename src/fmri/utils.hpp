@@ -4,10 +4,13 @@
 #include <array>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <fstream>
 #include <iterator>
+#include <ostream>
 #include <random>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 #include <ratio>
@@ -18,6 +21,10 @@ namespace fmri
 	typedef float DType;
 
 	typedef std::array<float, 4> Color;
+	/**
+	 * Color as uploaded to the GPU: 8-bit RGBA, always with an alpha channel.
+	 */
+	typedef std::array<std::uint8_t, 4> PackedColor;
 
 	extern Color NEUTRAL_COLOR;
 	extern Color POSITIVE_COLOR;
@@ -40,6 +47,25 @@ namespace fmri
 	    return r;
 	}
 
+	/**
+	 * Convert a color component in [0, 1] to 8 bits.
+	 */
+	inline std::uint8_t packComponent(float f) {
+	    return static_cast<std::uint8_t>(std::lround(std::clamp(f, 0.f, 1.f) * 255));
+	}
+
+	/**
+	 * Convert a color to its packed representation.
+	 *
+	 * Colors without alpha channel become opaque.
+	 */
+	inline PackedColor packColor(const Color& c) {
+	    PackedColor r = {0, 0, 0, 255};
+	    std::transform(c.begin(), c.end(), r.begin(), packComponent);
+
+	    return r;
+	}
+
     /**
      * The distance between layers in the visualisation.
      *
@@ -259,6 +285,20 @@ namespace fmri
      */
     const std::vector<float> & animate(const std::vector<float> &start, const std::vector<float> &delta, float time);
 
+    /**
+     * Make sure a directory exists, creating it if needed.
+     *
+     * Terminates the program if the path exists but is not a directory.
+     *
+     * @param dir
+     */
+    void ensureDirectory(const std::string& dir);
+
+    /**
+     * Write a string as a JSON string literal, escaping quotes, backslashes and control characters.
+     */
+    void writeJsonString(std::ostream& out, std::string_view str);
+
     /**
      * @return Whether alpha support is enabled, compile time.
      */
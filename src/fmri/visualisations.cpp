@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <cstdio>
 #include <numeric>
 #include <caffe/util/math_functions.hpp>
 #include <valarray>
@@ -11,15 +12,15 @@
 #include "InputLayerVisualisation.hpp"
 #include "PoolingLayerAnimation.hpp"
 #include "ImageInteractionAnimation.hpp"
+#include "LabelVisualisation.hpp"
 #include "RenderingState.hpp"
+#include "Tracer.hpp"
 
 using namespace fmri;
 using namespace std;
 
 std::size_t fmri::INTERACTION_LIMIT = 10000;
 
-typedef vector<pair<float, pair<size_t, size_t>>> EntryList;
-
 /**
  * Normalizer for node positions.
  *
@@ -46,15 +47,7 @@ static inline int getNodeNormalizer(const LayerData& layer) {
     }
 }
 
-/**
- * Deduplicate interaction entries.
- *
- * For duplicate interactions, the interaction strengths are summed.
- *
- * @param entries
- * @return the deduplicated entries.
- */
-static EntryList deduplicate(const EntryList& entries)
+EntryList fmri::deduplicate(const EntryList& entries)
 {
     map<pair<size_t, size_t>, float> combiner;
     for (auto entry : entries) {
@@ -101,6 +94,7 @@ static fmri::LayerVisualisation *getAppropriateLayer(const fmri::LayerData &data
 fmri::LayerVisualisation *fmri::getVisualisationForLayer(const fmri::LayerData &data, const fmri::LayerInfo &info)
 {
     LOG(INFO) << "Loading state visualisation for " << data.name();
+    Tracer::Span span("layer visualisation", data.name());
     auto layer = getAppropriateLayer(data, info);
     layer->setupLayerName(data.name(), info.type());
 
@@ -251,6 +245,7 @@ Animation * fmri::getActivityAnimation(const fmri::LayerData &prevState, const f
     }
 
     LOG(INFO) << "Loading interaction for " << layer.name();
+    Tracer::Span span("interaction animation", layer.name());
 
     switch (layer.type()) {
         case LayerInfo::Type::InnerProduct:
@@ -280,3 +275,136 @@ Animation * fmri::getActivityAnimation(const fmri::LayerData &prevState, const f
             return nullptr;
     }
 }
+
+InputVisualisation fmri::buildVisualisation(string_view name, shared_ptr<const vector<LayerData>> data,
+                                            const map<string, LayerInfo> &layerInfo,
+                                            const optional<vector<string>> &labels)
+{
+    vector<unique_ptr<LayerVisualisation>> layers;
+    vector<unique_ptr<Animation>> animations;
+    const LayerData* prevData = nullptr;
+
+    for (auto &layer : *data) {
+        unique_ptr<LayerVisualisation> layerVisualisation(getVisualisationForLayer(layer, layerInfo.at(layer.name())));
+
+        if (prevData != nullptr) {
+            auto animation = getActivityAnimation(*prevData, layer, layerInfo.at(layer.name()), (*layers.rbegin())->nodePositions(), layerVisualisation->nodePositions());
+            animations.emplace_back(animation);
+        }
+
+        layers.emplace_back(move(layerVisualisation));
+        prevData = &layer;
+    }
+
+    InputVisualisation dataSet;
+    dataSet.name = name;
+
+    if (labels) {
+        auto &last = *data->rbegin();
+        auto bestIndex = std::distance(last.data(), max_element(last.data(), last.data() + last.numEntries()));
+        LOG(INFO) << "Got answer: " << labels->at(bestIndex) << endl;
+        animations.emplace_back(new LabelVisualisation(layers.rbegin()->get()->nodePositions(), *prevData, labels.value()));
+    }
+
+    for (auto i = 0u; i < layers.size(); ++i) {
+        auto interaction = i < animations.size() ? move(animations[i]) : nullptr;
+        dataSet.layers.emplace_back(move(layers[i]), move(interaction));
+    }
+    dataSet.data = move(data);
+
+    return dataSet;
+}
+
+VisualisationUpdate fmri::updateVisualisation(const vector<LayerData> &previous, shared_ptr<const vector<LayerData>> data,
+                                              const vector<vector<float>> &positions,
+                                              const map<string, LayerInfo> &layerInfo,
+                                              const optional<vector<string>> &labels)
+{
+    const auto &layers = *data;
+    CHECK_EQ(layers.size(), previous.size()) << "Inputs should have the same layers.";
+    CHECK_EQ(layers.size(), positions.size()) << "Every layer should have node positions.";
+
+    vector<bool> changed;
+    for (auto i : Range(layers.size())) {
+        changed.push_back(!equal(layers[i].begin(), layers[i].end(), previous[i].begin(), previous[i].end()));
+    }
+
+    VisualisationUpdate update;
+    for (auto i : Range(layers.size())) {
+        if (changed[i]) {
+            update.layers.emplace_back(i, getVisualisationForLayer(layers[i], layerInfo.at(layers[i].name())));
+        }
+
+        if (i + 1 < layers.size() && (changed[i] || changed[i + 1])) {
+            auto &next = layers[i + 1];
+            update.animations.emplace_back(i, getActivityAnimation(layers[i], next, layerInfo.at(next.name()),
+                                                                   positions[i], positions[i + 1]));
+        } else if (i + 1 == layers.size() && labels && changed[i]) {
+            update.animations.emplace_back(i, new LabelVisualisation(positions[i], layers[i], labels.value()));
+        }
+    }
+    update.data = move(data);
+
+    return update;
+}
+
+/**
+ * Format a number of bytes with a binary unit.
+ */
+static string formatBytes(size_t bytes)
+{
+    char buffer[32];
+    if (bytes >= 1024 * 1024) {
+        snprintf(buffer, sizeof(buffer), "%.1f MiB", bytes / (1024.f * 1024.f));
+    } else {
+        snprintf(buffer, sizeof(buffer), "%.1f KiB", bytes / 1024.f);
+    }
+
+    return buffer;
+}
+
+void fmri::annotateCosts(InputVisualisation &input, const vector<chrono::steady_clock::duration> &forwardTimes)
+{
+    const auto layers = input.layers.size();
+    if (layers == 0) {
+        return;
+    }
+
+    vector<float> millis(layers, 0);
+    vector<size_t> memory(layers, 0);
+
+    for (auto i : Range(layers)) {
+        if (i < forwardTimes.size()) {
+            millis[i] = chrono::duration<float, milli>(forwardTimes[i]).count();
+        }
+    }
+
+    const auto maxMillis = *max_element(millis.begin(), millis.end());
+    vector<string> annotations(layers);
+
+    for (auto i : Range(layers)) {
+        const auto &[visualisation, animation] = input.layers[i];
+        auto buffers = visualisation->vertexBytes() + visualisation->indexBytes();
+        auto textures = visualisation->glMemoryUsage();
+        if (animation) {
+            buffers += animation->vertexBytes() + animation->indexBytes();
+            textures += animation->glMemoryUsage();
+        }
+        const auto activations = input.data->at(i).numEntries() * sizeof(DType);
+        memory[i] = activations + buffers + textures;
+
+        auto &annotation = annotations[i];
+        if (maxMillis > 0) {
+            char buffer[32];
+            snprintf(buffer, sizeof(buffer), "%.2f ms, ", millis[i]);
+            annotation = buffer;
+        }
+        annotation += "act " + formatBytes(activations) + ", buf " + formatBytes(buffers) + ", tex " + formatBytes(textures);
+    }
+
+    const auto maxMemory = *max_element(memory.begin(), memory.end());
+    for (auto i : Range(layers)) {
+        const auto heat = maxMillis > 0 ? millis[i] / maxMillis : static_cast<float>(memory[i]) / maxMemory;
+        input.layers[i].first->setAnnotation(annotations[i], heat);
+    }
+}
@@ -1,8 +1,16 @@
 #pragma once
 
+#include <chrono>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
 #include "LayerVisualisation.hpp"
 #include "LayerData.hpp"
 #include "Animation.hpp"
+#include "DrawList.hpp"
 #include "LayerInfo.hpp"
 
 namespace fmri {
@@ -20,6 +28,55 @@ namespace fmri {
      */
     extern std::size_t INTERACTION_LIMIT;
 
+    /**
+     * All visualisations for a single input.
+     *
+     * Every entry in layers holds the visualisation of a layer state, and
+     * optionally the animation of the interaction towards the next layer.
+     * The activations the visualisations were built from are kept, so
+     * individual nodes can be inspected. The static geometry of all
+     * layers is compiled into a draw list while the input is uploaded.
+     */
+    struct InputVisualisation
+    {
+        std::string name;
+        std::shared_ptr<const std::vector<LayerData>> data;
+        std::vector<std::pair<std::unique_ptr<LayerVisualisation>, std::unique_ptr<Animation>>> layers;
+        DrawList drawList;
+    };
+
+    /**
+     * Replacements for the parts of an input whose activations changed.
+     */
+    struct VisualisationUpdate
+    {
+        std::shared_ptr<const std::vector<LayerData>> data;
+        // Rebuilt layer visualisations, by layer index.
+        std::vector<std::pair<std::size_t, std::unique_ptr<LayerVisualisation>>> layers;
+        // Rebuilt animations, by layer index. Null if the layer no longer has one.
+        std::vector<std::pair<std::size_t, std::unique_ptr<Animation>>> animations;
+    };
+
+    /**
+     * Visualisations for every loaded input.
+     */
+    typedef std::vector<InputVisualisation> VisualisationList;
+
+    /**
+     * Interactions between nodes, as (strength, (source node, target node)).
+     */
+    typedef std::vector<std::pair<float, std::pair<std::size_t, std::size_t>>> EntryList;
+
+    /**
+     * Deduplicate interaction entries.
+     *
+     * For duplicate interactions, the interaction strengths are summed.
+     *
+     * @param entries
+     * @return the deduplicated entries, ordered by source and target node.
+     */
+    EntryList deduplicate(const EntryList& entries);
+
     /**
      * Generate a static visualisation of a layer state.
      *
@@ -31,4 +88,46 @@ namespace fmri {
     Animation * getActivityAnimation(const fmri::LayerData &prevState, const fmri::LayerData &curState,
                                      const fmri::LayerInfo &layer, const vector<float> &prevPositions,
                                      const vector<float> &curPositions);
+
+    /**
+     * Build the visualisations of all layers of a single input.
+     *
+     * @param name Name of the input.
+     * @param data Activations of every layer. Kept in the result.
+     * @param layerInfo Information on every layer of the network.
+     * @param labels Labels for the nodes of the last layer, if known.
+     */
+    InputVisualisation buildVisualisation(std::string_view name, std::shared_ptr<const std::vector<LayerData>> data,
+                                          const std::map<std::string, LayerInfo>& layerInfo,
+                                          const std::optional<std::vector<std::string>>& labels);
+
+    /**
+     * Rebuild only the visualisations affected by new activations of an input.
+     *
+     * A layer visualisation is rebuilt if the activations of its layer
+     * changed, an animation if those of either layer it connects did.
+     *
+     * @param previous Activations the current visualisations were built from.
+     * @param data New activations, of the same shapes. Kept in the result.
+     * @param positions Node positions of every layer, as built before.
+     * @param layerInfo Information on every layer of the network.
+     * @param labels Labels for the nodes of the last layer, if known.
+     */
+    VisualisationUpdate updateVisualisation(const std::vector<LayerData>& previous,
+                                            std::shared_ptr<const std::vector<LayerData>> data,
+                                            const std::vector<std::vector<float>>& positions,
+                                            const std::map<std::string, LayerInfo>& layerInfo,
+                                            const std::optional<std::vector<std::string>>& labels);
+
+    /**
+     * Annotate every layer of an input with its cost.
+     *
+     * Shows the forward time, activation size, buffer size and texture
+     * size of each layer below its name. Layers are coloured by their
+     * share of the forward time, or of the memory if no times are known.
+     *
+     * @param input Visualisations to annotate.
+     * @param forwardTimes Forward time of every layer, or empty if unknown.
+     */
+    void annotateCosts(InputVisualisation& input, const std::vector<std::chrono::steady_clock::duration>& forwardTimes);
 }
@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/program_options.hpp>
+#include <glog/logging.h>
+#include "../fmri/ActivationIndex.hpp"
+#include "../fmri/ActivationStatistics.hpp"
+#include "../fmri/Simulator.hpp"
+
+using namespace fmri;
+
+static struct
+{
+    std::string model;
+    std::string weights;
+    std::string means;
+    std::string output;
+    std::string index;
+    std::size_t top = 9;
+    std::size_t threads = 0;
+    bool merge = false;
+    std::vector<std::string> inputs;
+} options;
+
+static void read_options(int argc, char **argv)
+{
+    using namespace boost::program_options;
+
+    options_description desc("Options");
+    desc.add_options()
+            ("help,h", "show this message")
+            ("network,n", value(&options.model), "caffe model file for the network")
+            ("weights,w", value(&options.weights), "weights file for the network")
+            ("means,m", value(&options.means), "means file")
+            ("threads,t", value(&options.threads)->default_value(options.threads), "number of simulators to run in parallel, 0 for one per core")
+            ("output,o", value(&options.output), "file to write the statistics to")
+            ("index", value(&options.index), "file to write an index of the top inputs of every neuron or channel to")
+            ("top,k", value(&options.top)->default_value(options.top), "number of inputs per neuron or channel in the index")
+            ("merge", bool_switch(&options.merge), "merge statistics files instead of simulating inputs");
+
+    options_description hidden;
+    hidden.add_options()("input", value(&options.inputs)->required()->composing());
+
+    positional_options_description positionals;
+    positionals.add("input", -1);
+
+    options_description composed;
+    composed.add(desc).add(hidden);
+
+    const auto usage = [&]() {
+        return std::string("Usage: ") + argv[0] + " -n NETWORK -w WEIGHTS [-o OUTPUT] [--index INDEX] INPUTS...\n"
+               + "       " + argv[0] + " --merge -o OUTPUT STATISTICS...\n\n";
+    };
+
+    variables_map vm;
+    try {
+        store(command_line_parser(argc, argv).options(composed).positional(positionals).run(), vm);
+        if (vm.count("help")) {
+            std::cout << usage() << desc << '\n';
+            std::exit(0);
+        }
+        notify(vm);
+        if (!options.merge && (options.model.empty() || options.weights.empty())) {
+            throw error("a network and weights are needed to simulate inputs");
+        }
+        if (options.output.empty() && (options.merge || options.index.empty())) {
+            throw error("nothing to write, specify --output or --index");
+        }
+        if (options.merge && !options.index.empty()) {
+            throw error("indices cannot be merged");
+        }
+    } catch (error &e) {
+        std::cerr << e.what() << "\n\n" << usage() << desc << '\n';
+        std::exit(1);
+    }
+
+    if (options.threads == 0) {
+        options.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+/**
+ * Simulate all inputs, with a simulator per thread.
+ *
+ * Every thread holds the activations of a single input at a time, and
+ * adds them to the shared results one layer at a time.
+ */
+static void aggregate(ActivationStatistics &statistics, std::optional<ActivationIndex::Builder> &index)
+{
+    const auto &inputs = options.inputs;
+    const bool keepStatistics = !options.output.empty();
+
+    // The first input determines the layers.
+    Simulator simulator(options.model, options.weights, options.means);
+    const auto first = simulator.simulate(inputs.front());
+    if (keepStatistics) {
+        statistics.add(first);
+    }
+    if (index) {
+        index->add(0, first);
+    }
+
+    std::vector<std::mutex> layerLocks(first.size());
+    std::atomic<std::size_t> next(1);
+    std::atomic<std::size_t> processed(1);
+
+    const auto work = [&](Simulator &simulator) {
+        for (auto i = next++; i < inputs.size(); i = next++) {
+            const auto layers = simulator.simulate(inputs[i]);
+            CHECK_EQ(layers.size(), layerLocks.size()) << "Inputs should have the same layers.";
+            for (auto j = 0u; j < layers.size(); ++j) {
+                std::lock_guard<std::mutex> lock(layerLocks[j]);
+                if (keepStatistics) {
+                    statistics.add(j, layers[j]);
+                }
+                if (index) {
+                    index->add(j, i, layers[j]);
+                }
+            }
+
+            const auto done = ++processed;
+            LOG_IF(INFO, done % 100 == 0) << "Processed " << done << " of " << inputs.size() << " inputs";
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (auto i = 1u; i < options.threads; ++i) {
+        workers.emplace_back([&]() {
+            Simulator simulator(options.model, options.weights, options.means);
+            work(simulator);
+        });
+    }
+    work(simulator);
+
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+static ActivationStatistics merge()
+{
+    ActivationStatistics statistics;
+    for (auto &input : options.inputs) {
+        LOG(INFO) << "Merging " << input;
+        statistics.merge(ActivationStatistics::load(input));
+    }
+
+    return statistics;
+}
+
+int main(int argc, char **argv)
+{
+    google::InitGoogleLogging(argv[0]);
+    read_options(argc, argv);
+
+    ActivationStatistics statistics;
+    std::optional<ActivationIndex::Builder> index;
+    if (!options.index.empty()) {
+        index.emplace(options.top);
+    }
+
+    if (options.merge) {
+        statistics = merge();
+    } else {
+        aggregate(statistics, index);
+    }
+
+    if (!options.output.empty()) {
+        statistics.save(options.output);
+        LOG(INFO) << "Wrote statistics over " << statistics.count() << " inputs to " << options.output;
+    }
+    if (index) {
+        index->save(options.index, options.inputs);
+        LOG(INFO) << "Wrote index of " << options.inputs.size() << " inputs to " << options.index;
+    }
+
+    google::ShutdownGoogleLogging();
+    return 0;
+}
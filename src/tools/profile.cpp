@@ -0,0 +1,244 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <boost/program_options.hpp>
+#include <glog/logging.h>
+#include "../fmri/Simulator.hpp"
+#include "../fmri/utils.hpp"
+#include "../fmri/visualisations.hpp"
+
+using namespace fmri;
+
+typedef std::chrono::steady_clock Clock;
+
+static struct
+{
+    std::string model;
+    std::string weights;
+    std::string means;
+    std::string json;
+    std::size_t samples = 10;
+    std::size_t warmup = 1;
+    std::vector<std::string> inputs;
+} options;
+
+/**
+ * Cost of a single layer, summed over all profiled inputs.
+ */
+struct LayerCost
+{
+    std::string name;
+    LayerInfo::Type type;
+    double forwardMillis = 0;
+    double visualisationMillis = 0;
+    double animationMillis = 0;
+    std::size_t activationBytes = 0;
+    std::size_t vertexBytes = 0;
+    std::size_t indexBytes = 0;
+    std::size_t textureBytes = 0;
+    // High-water mark of the process after building this layer.
+    long peakRssKiB = 0;
+};
+
+static void read_options(int argc, char **argv)
+{
+    using namespace boost::program_options;
+
+    options_description desc("Options");
+    desc.add_options()
+            ("help,h", "show this message")
+            ("network,n", value(&options.model)->required(), "caffe model file for the network")
+            ("weights,w", value(&options.weights)->required(), "weights file for the network")
+            ("means,m", value(&options.means), "means file")
+            ("interaction-limit", value(&INTERACTION_LIMIT)->default_value(INTERACTION_LIMIT), "maximum number of interactions per layer")
+            ("samples,s", value(&options.samples)->default_value(options.samples), "number of inputs to profile, spread evenly over the inputs, 0 for all")
+            ("warmup", value(&options.warmup)->default_value(options.warmup), "number of unmeasured runs before profiling")
+            ("json,j", value(&options.json), "also write the report as JSON to this file");
+
+    options_description hidden;
+    hidden.add_options()("input", value(&options.inputs)->required()->composing());
+
+    positional_options_description positionals;
+    positionals.add("input", -1);
+
+    options_description composed;
+    composed.add(desc).add(hidden);
+
+    variables_map vm;
+    try {
+        store(command_line_parser(argc, argv).options(composed).positional(positionals).run(), vm);
+        if (vm.count("help")) {
+            std::cout << "Usage: " << argv[0] << " [OPTIONS] INPUTS...\n\n" << desc << '\n';
+            std::exit(0);
+        }
+        notify(vm);
+    } catch (error &e) {
+        std::cerr << e.what() << "\n\n" << "Usage: " << argv[0] << " [OPTIONS] INPUTS...\n\n" << desc << '\n';
+        std::exit(1);
+    }
+}
+
+static long peakRss()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static double millis(Clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+static std::vector<std::string> sampleInputs()
+{
+    const auto &inputs = options.inputs;
+    if (options.samples == 0 || options.samples >= inputs.size()) {
+        return inputs;
+    }
+
+    std::vector<std::string> sample;
+    for (auto i = 0u; i < options.samples; ++i) {
+        sample.push_back(inputs[i * inputs.size() / options.samples]);
+    }
+
+    return sample;
+}
+
+/**
+ * Simulate and visualise a single input, adding the costs of every layer.
+ */
+static void profileInput(Simulator &simulator, const std::string &input, std::vector<LayerCost> &costs)
+{
+    std::vector<Clock::duration> layerTimes;
+    const auto layers = simulator.simulate(input, layerTimes);
+    const auto &layerInfo = simulator.layerInfo();
+
+    costs.resize(layers.size());
+    std::unique_ptr<LayerVisualisation> previous;
+
+    for (auto i = 0u; i < layers.size(); ++i) {
+        const auto &layer = layers[i];
+        const auto &info = layerInfo.at(layer.name());
+        auto &cost = costs[i];
+
+        cost.name = layer.name();
+        cost.type = info.type();
+        cost.forwardMillis += millis(layerTimes.at(i));
+        cost.activationBytes += layer.numEntries() * sizeof(DType);
+
+        auto start = Clock::now();
+        std::unique_ptr<LayerVisualisation> visualisation(getVisualisationForLayer(layer, info));
+        cost.visualisationMillis += millis(Clock::now() - start);
+        cost.vertexBytes += visualisation->vertexBytes();
+        cost.indexBytes += visualisation->indexBytes();
+        cost.textureBytes += visualisation->glMemoryUsage();
+
+        if (previous) {
+            // The animation towards this layer is accounted to this layer.
+            start = Clock::now();
+            std::unique_ptr<Animation> animation(getActivityAnimation(layers[i - 1], layer, info,
+                                                                      previous->nodePositions(),
+                                                                      visualisation->nodePositions()));
+            cost.animationMillis += millis(Clock::now() - start);
+            if (animation) {
+                cost.vertexBytes += animation->vertexBytes();
+                cost.indexBytes += animation->indexBytes();
+                cost.textureBytes += animation->glMemoryUsage();
+            }
+        }
+
+        cost.peakRssKiB = std::max(cost.peakRssKiB, peakRss());
+        previous = std::move(visualisation);
+    }
+}
+
+static void writeTable(std::ostream &out, const std::vector<LayerCost> &costs, std::size_t runs)
+{
+    constexpr auto KiB = 1024.0;
+    out << std::left << std::setw(24) << "layer" << std::setw(14) << "type" << std::right
+        << std::setw(12) << "forward ms" << std::setw(10) << "vis ms" << std::setw(10) << "anim ms"
+        << std::setw(14) << "activ. KiB" << std::setw(12) << "vertex KiB" << std::setw(12) << "index KiB"
+        << std::setw(13) << "texture KiB" << std::setw(12) << "peak RSS MiB" << '\n';
+
+    out << std::fixed;
+    for (auto &cost : costs) {
+        std::ostringstream type;
+        type << cost.type;
+
+        out << std::left << std::setw(24) << cost.name << std::setw(14) << type.str() << std::right
+            << std::setprecision(2)
+            << std::setw(12) << cost.forwardMillis / runs
+            << std::setw(10) << cost.visualisationMillis / runs
+            << std::setw(10) << cost.animationMillis / runs
+            << std::setprecision(0)
+            << std::setw(14) << cost.activationBytes / runs / KiB
+            << std::setw(12) << cost.vertexBytes / runs / KiB
+            << std::setw(12) << cost.indexBytes / runs / KiB
+            << std::setw(13) << cost.textureBytes / runs / KiB
+            << std::setw(12) << cost.peakRssKiB / KiB << '\n';
+    }
+}
+
+static void writeJson(std::ostream &out, const std::vector<LayerCost> &costs, std::size_t runs)
+{
+    out << "{\n  \"inputs\": " << runs << ",\n  \"peak_rss_bytes\": " << peakRss() * 1024 << ",\n  \"layers\": [";
+    for (auto i = 0u; i < costs.size(); ++i) {
+        auto &cost = costs[i];
+        std::ostringstream type;
+        type << cost.type;
+
+        out << (i ? ",\n    {" : "\n    {") << "\"name\": ";
+        writeJsonString(out, cost.name);
+        out << ", \"type\": ";
+        writeJsonString(out, type.str());
+        out << ", \"forward_ms\": " << cost.forwardMillis / runs
+            << ", \"visualisation_ms\": " << cost.visualisationMillis / runs
+            << ", \"animation_ms\": " << cost.animationMillis / runs
+            << ", \"activation_bytes\": " << cost.activationBytes / runs
+            << ", \"vertex_bytes\": " << cost.vertexBytes / runs
+            << ", \"index_bytes\": " << cost.indexBytes / runs
+            << ", \"texture_bytes\": " << cost.textureBytes / runs
+            << ", \"peak_rss_bytes\": " << cost.peakRssKiB * 1024 << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+int main(int argc, char **argv)
+{
+    google::InitGoogleLogging(argv[0]);
+    read_options(argc, argv);
+
+    Simulator simulator(options.model, options.weights, options.means);
+    const auto inputs = sampleInputs();
+
+    std::vector<LayerCost> costs;
+    for (auto i = 0u; i < options.warmup; ++i) {
+        std::vector<Clock::duration> layerTimes;
+        simulator.simulate(inputs.front(), layerTimes);
+    }
+
+    for (auto &input : inputs) {
+        LOG(INFO) << "Profiling " << input;
+        profileInput(simulator, input, costs);
+    }
+
+    writeTable(std::cout, costs, inputs.size());
+    std::cout << "\nPeak RSS: " << peakRss() / 1024 << " MiB over " << inputs.size() << " inputs\n";
+
+    if (!options.json.empty()) {
+        std::ofstream json(options.json);
+        CHECK(json) << "Failed to open " << options.json;
+        writeJson(json, costs, inputs.size());
+    }
+
+    google::ShutdownGoogleLogging();
+    return 0;
+}